@@ -0,0 +1,81 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <wchar.h>
+#include <time.h>
+
+#include "chessboard.h"
+#include "move_types.h"
+#include "moves.h"
+#include "move_array.h"
+#include "evaluation.h"
+#include "engine.h"
+#include "transposition.h"
+#include "bench.h"
+
+/*
+    bench:
+    Searches a fixed set of positions to a fixed depth, starting every position from an empty
+    transposition table. The total number of nodes is a signature of the search: it must only
+    change when the search itself is changed (move ordering, pruning, ...), never because of a
+    faster or slower build. Time and nodes/second are what we compare between builds.
+
+    Usage: ./chess bench [depth]
+*/
+
+const BenchPosition bench_positions[] = {
+    {"rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1", WHITE},
+    {"r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1", WHITE},
+    {"8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1", WHITE},
+    {"r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1", WHITE},
+    {"rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8", WHITE},
+    {"r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10", WHITE},
+    {"r1bqkb1r/pppp1ppp/2n2n2/4p2Q/2B1P3/8/PPPP1PPP/RNB1K1NR w KQkq - 4 4", WHITE},
+    {"r1bq1rk1/pp2bppp/2n1pn2/3p4/2PP4/2N1PN2/PP2BPPP/R2QKB1R b KQ - 0 8", BLACK},
+    {"2r3k1/pp3ppp/4p3/3n4/3P4/1B3N2/PP3PPP/2R3K1 b - - 0 20", BLACK},
+    {"8/5pk1/6p1/8/3R4/6P1/5PK1/2r5 w - - 0 1", WHITE},
+    {"6k1/5ppp/8/8/8/8/5PPP/3B2K1 b - - 0 1", BLACK},
+    {"8/1P3k2/8/8/8/8/2K3p1/8 w - - 0 1", WHITE}};
+
+const int num_bench_positions = sizeof(bench_positions) / sizeof(BenchPosition);
+
+void bench(int depth) {
+	unsigned long long total_nodes = 0, total_qnodes = 0, total_cutoffs = 0, total_first_move_cutoffs = 0;
+	double total_time = 0;
+
+	init_zobrist(&transposition_table);
+
+	for (int i = 0; i < num_bench_positions; i++) {
+		board b;
+		load_fen(&b, bench_positions[i].fen);
+		update_attacks(&b);
+		clear_table(&transposition_table);
+		clear_move_ordering();
+		engine_stats = (search_stats){0};
+
+		clock_t start = clock();
+		evaluated_move eval = minimax(&b, depth, bench_positions[i].turn, -INFINITE_SCORE, INFINITE_SCORE);
+		clock_t end = clock();
+
+		double time_ms = ((double)(end - start) * 1000.0) / CLOCKS_PER_SEC;
+		total_nodes += engine_stats.nodes;
+		total_qnodes += engine_stats.qnodes;
+		total_cutoffs += engine_stats.cutoffs;
+		total_first_move_cutoffs += engine_stats.first_move_cutoffs;
+		total_time += time_ms;
+
+		wprintf(L"Position %2d: best move %c%d%c%d, nodes %llu, time_ms %.2lf\n", i + 1,
+		        eval.best_move.src.file + 'a' - 1, eval.best_move.src.rank, eval.best_move.dest.file + 'a' - 1, eval.best_move.dest.rank,
+		        engine_stats.nodes, time_ms);
+		free_board(&b);
+	}
+
+	wprintf(L"\n===========================\n");
+	wprintf(L"Depth           : %d\n", depth);
+	wprintf(L"Total time (ms) : %.0lf\n", total_time);
+	wprintf(L"Nodes searched  : %llu\n", total_nodes);
+	wprintf(L"Quiescence nodes: %llu\n", total_qnodes);
+	wprintf(L"First move cuts : %.1lf%% of %llu cutoffs\n", total_cutoffs ? total_first_move_cutoffs * 100.0 / total_cutoffs : 0, total_cutoffs);
+	wprintf(L"Nodes/second    : %.0lf\n", total_time > 0 ? total_nodes * 1000.0 / total_time : 0);
+}
@@ -0,0 +1,15 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+#define BENCH_DEPTH 11
+
+typedef struct {
+	char* fen;
+	short turn;
+} BenchPosition;
+
+extern const BenchPosition bench_positions[];
+extern const int num_bench_positions;
+
+void bench(int depth);
+#endif
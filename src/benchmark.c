@@ -0,0 +1,380 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <wchar.h>
+#include <locale.h>
+#include <time.h>
+#include <math.h>
+
+#include "chessboard.h"
+#include "move_types.h"
+#include "moves.h"
+#include "move_array.h"
+#include "move_stack.h"
+#include "evaluation.h"
+#include "transposition.h"
+
+/*
+    Micro benchmarks for the move generation primitives:
+    Every primitive is timed in isolation over the positions of a fixed corpus (bench_positions.fen).
+    One round runs every position 'iterations' times, several rounds are run and the mean, the
+    standard deviation and the best ns/op over the rounds are reported, so the numbers of two
+    builds can be compared together with their noise.
+
+    Usage:
+    ./benchmarks [iterations] [rounds] [corpus]
+    ./benchmarks generate [positions per category] [corpus]
+*/
+
+#define CORPUS_FILE "bench_positions.fen"
+#define DEFAULT_ITERATIONS 50
+#define DEFAULT_ROUNDS 5
+#define MAX_ROUNDS 64
+#define MAX_FEN_LENGTH 128
+
+typedef struct {
+	char fen[MAX_FEN_LENGTH];
+	short turn;
+} Position;
+
+typedef struct {
+	Position* positions;
+	int count;
+} Corpus;
+
+typedef enum {
+	BENCH_ATTACKS,
+	BENCH_FILTER,
+	BENCH_MAKE_UNMAKE,
+	BENCH_ZOBRIST,
+	BENCH_EVALUATION,
+	NUM_BENCHMARKS
+} Benchmark;
+
+const wchar_t* benchmark_names[NUM_BENCHMARKS] = {
+    L"update_attacks_for_color",
+    L"filter_legal_moves",
+    L"make_move + unmake_move",
+    L"get_zobrist_key",
+    L"get_evaluation_of_board"};
+
+// per round totals, one op is one call (one make/unmake pair for BENCH_MAKE_UNMAKE)
+typedef struct {
+	double ns[NUM_BENCHMARKS];
+	unsigned long long ops[NUM_BENCHMARKS];
+} RoundResult;
+
+ZobristTable zobrist;
+
+static double now_ns() {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+static short turn_from_fen(const char* fen) {
+	const char* side = strchr(fen, ' ');
+	return (side && side[1] == 'b') ? BLACK : WHITE;
+}
+
+Corpus load_corpus(const char* filename) {
+	Corpus corpus = {NULL, 0};
+	FILE* file = fopen(filename, "r");
+	if (!file) {
+		wprintf(L"Error opening corpus %s\n", filename);
+		exit(1);
+	}
+
+	int capacity = 1024;
+	corpus.positions = (Position*)malloc(sizeof(Position) * capacity);
+
+	char line[256];
+	while (fgets(line, sizeof(line), file)) {
+		line[strcspn(line, "\r\n")] = '\0';
+		// '#' starts a comment, used for the category headers
+		if (line[0] == '\0' || line[0] == '#') {
+			continue;
+		}
+		if (corpus.count == capacity) {
+			capacity *= 2;
+			corpus.positions = (Position*)realloc(corpus.positions, sizeof(Position) * capacity);
+		}
+		Position* p = &corpus.positions[corpus.count++];
+		strncpy(p->fen, line, MAX_FEN_LENGTH - 1);
+		p->fen[MAX_FEN_LENGTH - 1] = '\0';
+		p->turn = turn_from_fen(p->fen);
+	}
+
+	fclose(file);
+	return corpus;
+}
+
+// brings the board to the state the search sees it in: attacks of both sides and legal moves
+static void prepare_board(board* b, short turn) {
+	b->white_attacks->move_count = 0;
+	b->black_attacks->move_count = 0;
+	update_attacks_for_color(b, !turn);
+	update_attacks_for_color(b, turn);
+	filter_legal_moves(b, turn);
+}
+
+static void bench_position(const Position* p, int iterations, RoundResult* result) {
+	board b;
+	load_fen(&b, (char*)p->fen);
+	short turn = p->turn;
+	MoveList* pseudo_legal_moves = turn == WHITE ? b.white_attacks : b.black_attacks;
+	MoveList* legal_moves = turn == WHITE ? b.white_legal_moves : b.black_legal_moves;
+	double start;
+	volatile double sink = 0;
+
+	prepare_board(&b, turn);
+
+	start = now_ns();
+	for (int i = 0; i < iterations; i++) {
+		pseudo_legal_moves->move_count = 0;
+		update_attacks_for_color(&b, turn);
+	}
+	result->ns[BENCH_ATTACKS] += now_ns() - start;
+	result->ops[BENCH_ATTACKS] += iterations;
+
+	start = now_ns();
+	for (int i = 0; i < iterations; i++) {
+		filter_legal_moves(&b, turn);
+	}
+	result->ns[BENCH_FILTER] += now_ns() - start;
+	result->ops[BENCH_FILTER] += iterations;
+
+	int move_count = legal_moves->move_count;
+	Move moves[move_count];
+	memcpy(moves, legal_moves->moves, sizeof(Move) * move_count);
+
+	start = now_ns();
+	for (int i = 0; i < iterations; i++) {
+		for (int j = 0; j < move_count; j++) {
+			if (make_move(moves[j].src, moves[j].dest, turn, &b, true, moves[j].type) != INVALID_MOVE) {
+				unmake_move(&b);
+			}
+		}
+	}
+	result->ns[BENCH_MAKE_UNMAKE] += now_ns() - start;
+	result->ops[BENCH_MAKE_UNMAKE] += (unsigned long long)iterations * move_count;
+
+	start = now_ns();
+	for (int i = 0; i < iterations; i++) {
+		sink += get_zobrist_key(&b, &zobrist, turn);
+	}
+	result->ns[BENCH_ZOBRIST] += now_ns() - start;
+	result->ops[BENCH_ZOBRIST] += iterations;
+
+	start = now_ns();
+	for (int i = 0; i < iterations; i++) {
+		sink += get_evaluation_of_board(&b);
+	}
+	result->ns[BENCH_EVALUATION] += now_ns() - start;
+	result->ops[BENCH_EVALUATION] += iterations;
+
+	free_board(&b);
+}
+
+void run_benchmarks(Corpus* corpus, int iterations, int rounds) {
+	RoundResult results[MAX_ROUNDS];
+
+	wprintf(L"%d positions, %d iterations per position, %d rounds\n\n", corpus->count, iterations, rounds);
+	for (int r = 0; r < rounds; r++) {
+		memset(&results[r], 0, sizeof(RoundResult));
+		for (int i = 0; i < corpus->count; i++) {
+			bench_position(&corpus->positions[i], iterations, &results[r]);
+		}
+	}
+
+	wprintf(L"%-26ls %12ls %10ls %8ls %12ls\n", L"primitive", L"mean ns/op", L"stddev", L"rsd %", L"best ns/op");
+	for (int k = 0; k < NUM_BENCHMARKS; k++) {
+		double sum = 0, sum_sq = 0, best = INFINITY;
+		for (int r = 0; r < rounds; r++) {
+			double ns_per_op = results[r].ops[k] ? results[r].ns[k] / results[r].ops[k] : 0;
+			sum += ns_per_op;
+			sum_sq += ns_per_op * ns_per_op;
+			best = ns_per_op < best ? ns_per_op : best;
+		}
+		double mean = sum / rounds;
+		double variance = rounds > 1 ? (sum_sq - rounds * mean * mean) / (rounds - 1) : 0;
+		double stddev = variance > 0 ? sqrt(variance) : 0;
+		wprintf(L"%-26ls %12.1lf %10.1lf %8.2lf %12.1lf\n", benchmark_names[k], mean, stddev, mean ? 100.0 * stddev / mean : 0, best);
+	}
+}
+
+/*
+    Corpus generation:
+    Positions are produced by random legal playouts (fixed seed, so the corpus is reproducible)
+    from a handful of seed positions of each category, duplicates are skipped.
+*/
+typedef struct {
+	const char* name;
+	const char* seeds[4];
+	int min_plies, max_plies;
+} Category;
+
+const Category categories[] = {
+    {"opening", {"rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1"}, 4, 14},
+    {"middlegame",
+     {"r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+      "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+      "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+      "r1bq1rk1/pp2bppp/2n1pn2/3p4/2PP4/2N1PN2/PP2BPPP/R2QKB1R w KQ - 0 8"},
+     1, 20},
+    {"endgame",
+     {"8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+      "8/5pk1/6p1/8/3R4/6P1/5PK1/2r5 w - - 0 1",
+      "6k1/5ppp/8/8/8/8/5PPP/3B2K1 w - - 0 1",
+      "8/8/1k6/8/4N3/4K3/8/6Q1 w - - 0 1"},
+     1, 30},
+    {"promotion",
+     {"r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+      "8/PPP4k/8/8/8/8/4Kppp/8 w - - 0 1",
+      "n1n5/PPPk4/8/8/8/8/4Kppp/5N1N w - - 0 1",
+      "8/1P3k2/8/8/8/8/2K3p1/8 w - - 0 1"},
+     1, 8}};
+
+static char piece_char(uint8_t piece) {
+	const char* symbols = "pnbrqk";
+	char c = symbols[piece_type(piece) - 1];
+	return piece_color(piece) == WHITE ? c - 'a' + 'A' : c;
+}
+
+void board_to_fen(board* b, short turn, char* fen) {
+	int n = 0;
+	for (int rank = 8; rank >= 1; rank--) {
+		int empty = 0;
+		for (int file = A; file <= H; file++) {
+			uint8_t piece = b->square_table[file - 1][rank - 1];
+			if (piece == EMPTY_SQUARE) {
+				empty++;
+				continue;
+			}
+			if (empty) {
+				fen[n++] = '0' + empty;
+				empty = 0;
+			}
+			fen[n++] = piece_char(piece);
+		}
+		if (empty) {
+			fen[n++] = '0' + empty;
+		}
+		if (rank > 1) {
+			fen[n++] = '/';
+		}
+	}
+
+	fen[n++] = ' ';
+	fen[n++] = turn == WHITE ? 'w' : 'b';
+	fen[n++] = ' ';
+
+	int rights_start = n;
+	if ((b->castle_rights & WHITE_KING_SIDE_CASTLE_RIGHTS) == WHITE_KING_SIDE_CASTLE_RIGHTS) fen[n++] = 'K';
+	if ((b->castle_rights & WHITE_QUEEN_SIDE_CASTLE_RIGHTS) == WHITE_QUEEN_SIDE_CASTLE_RIGHTS) fen[n++] = 'Q';
+	if ((b->castle_rights & BLACK_KING_SIDE_CASTLE_RIGHTS) == BLACK_KING_SIDE_CASTLE_RIGHTS) fen[n++] = 'k';
+	if ((b->castle_rights & BLACK_QUEEN_SIDE_CASTLE_RIGHTS) == BLACK_QUEEN_SIDE_CASTLE_RIGHTS) fen[n++] = 'q';
+	if (n == rights_start) fen[n++] = '-';
+
+	fen[n++] = ' ';
+	if (b->en_passant_square) {
+		square ep = get_square_from_bitboard(b->en_passant_square);
+		fen[n++] = 'a' + ep.file - 1;
+		fen[n++] = '0' + ep.rank;
+	} else {
+		fen[n++] = '-';
+	}
+	strcpy(fen + n, " 0 1");
+}
+
+void generate_corpus(int per_category, const char* filename) {
+	int num_categories = sizeof(categories) / sizeof(Category);
+	char(*generated_fens)[MAX_FEN_LENGTH] = malloc(sizeof(*generated_fens) * per_category * num_categories);
+	int total = 0;
+	srand(20241018);
+
+	FILE* file = fopen(filename, "w");
+	if (!file) {
+		wprintf(L"Error opening %s\n", filename);
+		exit(1);
+	}
+
+	for (int c = 0; c < num_categories; c++) {
+		const Category* category = &categories[c];
+		int num_seeds = 0;
+		while (num_seeds < 4 && category->seeds[num_seeds]) num_seeds++;
+
+		fprintf(file, "# %s\n", category->name);
+		int generated = 0;
+		while (generated < per_category) {
+			board b;
+			const char* seed = category->seeds[generated % num_seeds];
+			load_fen(&b, (char*)seed);
+			short turn = turn_from_fen(seed);
+			int plies = category->min_plies + rand() % (category->max_plies - category->min_plies + 1);
+
+			bool finished = true;
+			for (int i = 0; i < plies; i++) {
+				prepare_board(&b, turn);
+				MoveList* legal_moves = turn == WHITE ? b.white_legal_moves : b.black_legal_moves;
+				if (legal_moves->move_count == 0) {
+					finished = false;
+					break;
+				}
+				Move m = legal_moves->moves[rand() % legal_moves->move_count];
+				make_move(m.src, m.dest, turn, &b, true, m.type);
+				turn = !turn;
+			}
+
+			// positions without legal moves are of no use for the benchmarks
+			prepare_board(&b, turn);
+			if (finished && (turn == WHITE ? b.white_legal_moves : b.black_legal_moves)->move_count) {
+				char* fen = generated_fens[total];
+				board_to_fen(&b, turn, fen);
+
+				bool duplicate = false;
+				for (int i = 0; i < total && !duplicate; i++) {
+					duplicate = strcmp(generated_fens[i], fen) == 0;
+				}
+				if (!duplicate) {
+					fprintf(file, "%s\n", fen);
+					generated++;
+					total++;
+				}
+			}
+			free_board(&b);
+		}
+	}
+
+	fclose(file);
+	free(generated_fens);
+	wprintf(L"%d positions written to %s\n", total, filename);
+}
+
+int main(int argc, char* argv[]) {
+	setlocale(LC_ALL, "");
+
+	if (argc > 1 && strcmp(argv[1], "generate") == 0) {
+		generate_corpus(argc > 2 ? atoi(argv[2]) : 750, argc > 3 ? argv[3] : CORPUS_FILE);
+		return 0;
+	}
+
+	int iterations = argc > 1 ? atoi(argv[1]) : DEFAULT_ITERATIONS;
+	int rounds = argc > 2 ? atoi(argv[2]) : DEFAULT_ROUNDS;
+	const char* corpus_file = argc > 3 ? argv[3] : CORPUS_FILE;
+
+	if (iterations < 1 || rounds < 1 || rounds > MAX_ROUNDS) {
+		wprintf(L"Invalid arguments, usage: ./benchmarks [iterations] [rounds <= %d] [corpus]\n", MAX_ROUNDS);
+		return 1;
+	}
+
+	// only the keys are benchmarked, the table is never probed: the smallest one (a single bucket)
+	// keeps init_zobrist from allocating the default DEFAULT_HASH_MB
+	resize_table(&zobrist, 0);
+	init_zobrist(&zobrist);
+	Corpus corpus = load_corpus(corpus_file);
+	run_benchmarks(&corpus, iterations, rounds);
+	free(corpus.positions);
+	return 0;
+}
@@ -0,0 +1,13 @@
+#!/bin/bash
+
+if ls *.c 1> /dev/null 2>&1; then
+    gcc $(ls *.c | grep -v -e 'main.c' -e 'engine.c' -e 'bench.c' -e 'perft.c' -e 'tests.c' -e 'regression.c' -e 'scaling.c') -lm -O2 -g -o benchmarks
+
+    if [ $? -eq 0 ]; then
+        echo "Compilation successful. Output file: benchmarks"
+    else
+        echo "Compilation failed."
+    fi
+else
+    echo "No C files found in the directory."
+fi
@@ -237,6 +237,7 @@ void init_board(board *b) {
 	b->black_board = 0ULL;
 	b->en_passant_square = 0ULL;
 	b->castle_rights = 0b01110111;
+	b->halfmove_clock = 0;
 
 	// Initialize captured pieces count
 	b->captured_pieces_count[0] = 0;
@@ -253,14 +254,41 @@ void init_board(board *b) {
 
 }
 
+// function to release everything init_board and load_fen allocated for the board
+void free_board(board *b) {
+	if (!b) return;
+
+	pieces *sides[2] = {b->white, b->black};
+	for (int i = 0; i < 2; i++) {
+		free(sides[i]->pawns);
+		free(sides[i]->knights);
+		free(sides[i]->bishops);
+		free(sides[i]->rooks);
+		free(sides[i]->queen);
+		free(sides[i]);
+	}
+
+	while (b->moves->top) {
+		pop(b->moves);
+	}
+	free(b->moves);
+
+	free(b->white_attacks);
+	free(b->black_attacks);
+	free(b->white_legal_moves);
+	free(b->black_legal_moves);
+	return;
+}
+
 // function to initialize the pieces: allocate memory
 void init_pieces(pieces *type) {
 	// Memory is allocated dynamically to implement the pawn promotion feature by using realloc function
+	// (there is room for 8 promoted pieces so that FENs with promoted pieces can be loaded)
 	type->pawns = (uint64_t *)malloc(sizeof(uint64_t) * 8);
-	type->knights = (uint64_t *)malloc(sizeof(uint64_t) * 2);
-	type->bishops = (uint64_t *)malloc(sizeof(uint64_t) * 2);
-	type->rooks = (uint64_t *)malloc(sizeof(uint64_t) * 2);
-	type->queen = (uint64_t *)malloc(sizeof(uint64_t));
+	type->knights = (uint64_t *)malloc(sizeof(uint64_t) * 10);
+	type->bishops = (uint64_t *)malloc(sizeof(uint64_t) * 10);
+	type->rooks = (uint64_t *)malloc(sizeof(uint64_t) * 10);
+	type->queen = (uint64_t *)malloc(sizeof(uint64_t) * 9);
 	return;
 }
 
@@ -284,6 +312,17 @@ uint8_t generate_id_for_piece(uint8_t piece_type, short color, short piece_numbe
 	return (piece_type | (color << 3) | (piece_number << 4));
 }
 
+// pieces beyond the standard set get the ids of promoted pieces, same as update_attacks_for_color expects
+uint8_t generate_id_for_fen_piece(uint8_t piece_type, short color, short piece_number) {
+	uint8_t id = generate_id_for_piece(piece_type, color, piece_number);
+	short standard_count = piece_type == QUEEN ? 1 : 2;
+
+	if ((piece_type == KNIGHT || piece_type == BISHOP || piece_type == ROOK || piece_type == QUEEN) && piece_number >= standard_count) {
+		id |= 0b10000000;
+	}
+	return id;
+}
+
 uint64_t place_piece(uint64_t *piece_board, int file, int rank, uint8_t piece, board *b) {
 	*piece_board = get_bitboard(file, rank);
 	update_square_table(file, rank, piece, b);
@@ -328,71 +367,71 @@ void load_fen(board *b, char *fen) {
 			case 'P':
 				b->white->count.pawns++;
 				expected_piece_count[WHITE][0]--;
-				piece = generate_id_for_piece(PAWN, WHITE, b->white->count.pawns - 1);
+				piece = generate_id_for_fen_piece(PAWN, WHITE, b->white->count.pawns - 1);
 				b->white_board |= place_piece(b->white->pawns + (b->white->count.pawns - 1), file, rank, piece, b);
 				break;
 			case 'p':
 				b->black->count.pawns++;
 				expected_piece_count[BLACK][0]--;
-				piece = generate_id_for_piece(PAWN, BLACK, b->black->count.pawns - 1);
+				piece = generate_id_for_fen_piece(PAWN, BLACK, b->black->count.pawns - 1);
 				b->black_board |= place_piece(b->black->pawns + (b->black->count.pawns - 1), file, rank, piece, b);
 				break;
 			case 'R':
 				b->white->count.rooks++;
 				expected_piece_count[WHITE][1]--;
-				piece = generate_id_for_piece(ROOK, WHITE, b->white->count.rooks - 1);
+				piece = generate_id_for_fen_piece(ROOK, WHITE, b->white->count.rooks - 1);
 				b->white_board |= place_piece(b->white->rooks + (b->white->count.rooks - 1), file, rank, piece, b);
 				break;
 			case 'r':
 				b->black->count.rooks++;
 				expected_piece_count[BLACK][1]--;
-				piece = generate_id_for_piece(ROOK, BLACK, b->black->count.rooks - 1);
+				piece = generate_id_for_fen_piece(ROOK, BLACK, b->black->count.rooks - 1);
 				b->black_board |= place_piece(b->black->rooks + (b->black->count.rooks - 1), file, rank, piece, b);
 				break;
 			case 'N':
 				b->white->count.knights++;
 				expected_piece_count[WHITE][2]--;
-				piece = generate_id_for_piece(KNIGHT, WHITE, b->white->count.knights - 1);
+				piece = generate_id_for_fen_piece(KNIGHT, WHITE, b->white->count.knights - 1);
 				b->white_board |= place_piece(b->white->knights + (b->white->count.knights - 1), file, rank, piece, b);
 				break;
 			case 'n':
 				b->black->count.knights++;
 				expected_piece_count[BLACK][2]--;
-				piece = generate_id_for_piece(KNIGHT, BLACK, b->black->count.knights - 1);
+				piece = generate_id_for_fen_piece(KNIGHT, BLACK, b->black->count.knights - 1);
 				b->black_board |= place_piece(b->black->knights + (b->black->count.knights - 1), file, rank, piece, b);
 				break;
 			case 'B':
 				b->white->count.bishops++;
 				expected_piece_count[WHITE][3]--;
-				piece = generate_id_for_piece(BISHOP, WHITE, b->white->count.bishops - 1);
+				piece = generate_id_for_fen_piece(BISHOP, WHITE, b->white->count.bishops - 1);
 				b->white_board |= place_piece(b->white->bishops + (b->white->count.bishops - 1), file, rank, piece, b);
 				break;
 			case 'b':
 				b->black->count.bishops++;
 				expected_piece_count[BLACK][3]--;
-				piece = generate_id_for_piece(BISHOP, BLACK, b->black->count.bishops - 1);
+				piece = generate_id_for_fen_piece(BISHOP, BLACK, b->black->count.bishops - 1);
 				b->black_board |= place_piece(b->black->bishops + (b->black->count.bishops - 1), file, rank, piece, b);
 				break;
 			case 'Q':
 				b->white->count.queens++;
 				expected_piece_count[WHITE][4]--;
-				piece = generate_id_for_piece(QUEEN, WHITE, b->white->count.queens - 1);
+				piece = generate_id_for_fen_piece(QUEEN, WHITE, b->white->count.queens - 1);
 				b->white_board |= place_piece(b->white->queen + (b->white->count.queens - 1), file, rank, piece, b);
 				break;
 			case 'q':
 				b->black->count.queens++;
 				expected_piece_count[BLACK][4]--;
-				piece = generate_id_for_piece(QUEEN, BLACK, b->black->count.queens - 1);
+				piece = generate_id_for_fen_piece(QUEEN, BLACK, b->black->count.queens - 1);
 				b->black_board |= place_piece(b->black->queen + (b->black->count.queens - 1), file, rank, piece, b);
 				break;
 			case 'K':
 				expected_piece_count[WHITE][5]--;
-				piece = generate_id_for_piece(KING, WHITE, 0);
+				piece = generate_id_for_fen_piece(KING, WHITE, 0);
 				b->white_board |= place_piece(&b->white->king, file, rank, piece, b);
 				break;
 			case 'k':
 				expected_piece_count[BLACK][5]--;
-				piece = generate_id_for_piece(KING, BLACK, 0);
+				piece = generate_id_for_fen_piece(KING, BLACK, 0);
 				b->black_board |= place_piece(&b->black->king, file, rank, piece, b);
 				break;
 			default:
@@ -401,21 +440,19 @@ void load_fen(board *b, char *fen) {
 		file++;
 	}
 
-	// Now process the en passant target square (it's the part after the first space)
-	char *en_passant = strchr(fen, ' ');  // Find the first space, then move to the next part
+	// fields after the piece placement: side to move, castling rights, en passant square, halfmove clock
+	char *castle_rights = strchr(fen, ' ');
+	castle_rights = castle_rights ? strchr(castle_rights + 1, ' ') : NULL;
+	castle_rights = castle_rights ? castle_rights + 1 : "-";
 
-	while (*en_passant == ' ' || *en_passant == '-' || *en_passant == 'w' || *en_passant == 'b') {
-		en_passant++;
-	}
+	char *en_passant = strchr(castle_rights, ' ');
+	en_passant = en_passant ? en_passant + 1 : "-";
 
 	// Extract the en passant square, check if valid (not '-')
-	if (*en_passant != '-') {
-		char file_char = en_passant[0];  // File character (e.g., 'c')
-		char rank_char = en_passant[1];  // Rank character (e.g., '6')
-
+	if (en_passant[0] >= 'a' && en_passant[0] <= 'h' && en_passant[1] >= '1' && en_passant[1] <= '8') {
 		// Convert to file and rank (file 'a' = 1, 'b' = 2, ..., 'h' = 8)
-		int en_passant_file = file_char - 'a' + 1;
-		int en_passant_rank = rank_char - '0';
+		int en_passant_file = en_passant[0] - 'a' + 1;
+		int en_passant_rank = en_passant[1] - '0';
 
 		// Set the en passant square bitboard
 		b->en_passant_square = get_bitboard(en_passant_file, en_passant_rank);
@@ -424,35 +461,43 @@ void load_fen(board *b, char *fen) {
 		b->en_passant_square = 0;
 	}
 
-	// castling rights
-	char *castle_rights = strchr(fen, ' ');              // Find the first space, then move to the next part
-	castle_rights = strchr(castle_rights + 1, ' ') + 1;  // Find the second space, then move to the next part
+	// halfmove clock, 0 if the field is missing (FENs with four fields only)
+	char *halfmove_clock = strchr(en_passant, ' ');
+	int clock = halfmove_clock ? atoi(halfmove_clock + 1) : 0;
+	b->halfmove_clock = clock < 0 ? 0 : clock > UINT8_MAX ? UINT8_MAX : clock;
 
-	if (strchr(castle_rights, 'K')) {
-		b->castle_rights |= WHITE_KING_SIDE_CASTLE_RIGHTS;
-	}
-	if (strchr(castle_rights, 'Q')) {
-		b->castle_rights |= WHITE_QUEEN_SIDE_CASTLE_RIGHTS;
-	}
-	if (strchr(castle_rights, 'k')) {
-		b->castle_rights |= BLACK_KING_SIDE_CASTLE_RIGHTS;
-	}
-	if (strchr(castle_rights, 'q')) {
-		b->castle_rights |= BLACK_QUEEN_SIDE_CASTLE_RIGHTS;
-	}
-
-	if (strchr(castle_rights, 'K') == NULL && strchr(castle_rights, 'Q') == NULL && strchr(castle_rights, 'k') == NULL && strchr(castle_rights, 'q') == NULL) {
-		b->castle_rights = 0;
+	// castling rights, only the characters up to the end of the field are considered
+	b->castle_rights = 0;
+	for (char *c = castle_rights; *c && *c != ' '; c++) {
+		switch (*c) {
+			case 'K':
+				b->castle_rights |= WHITE_KING_SIDE_CASTLE_RIGHTS;
+				break;
+			case 'Q':
+				b->castle_rights |= WHITE_QUEEN_SIDE_CASTLE_RIGHTS;
+				break;
+			case 'k':
+				b->castle_rights |= BLACK_KING_SIDE_CASTLE_RIGHTS;
+				break;
+			case 'q':
+				b->castle_rights |= BLACK_QUEEN_SIDE_CASTLE_RIGHTS;
+				break;
+			default:
+				break;
+		}
 	}
 
-	// Populate captured pieces based on remaining counts in expected_piece_count
+	// Populate captured pieces based on remaining counts in expected_piece_count,
+	// a missing piece of one color was captured by the other color
+	const uint8_t expected_piece_types[6] = {PAWN, ROOK, KNIGHT, BISHOP, QUEEN, KING};
+	const int standard_piece_count[6] = {8, 2, 2, 2, 1, 1};
 	for (int color = 0; color < 2; color++) {
-		int index = 0;
+		short captor = !color;
 		for (int type = 0; type < 6; type++) {
 			for (int count = 0; count < expected_piece_count[color][type]; count++) {
-				b->captured_pieces[color][index++] = generate_id_for_piece(type, color, count);
+				short piece_number = standard_piece_count[type] - expected_piece_count[color][type] + count;
+				b->captured_pieces[captor][b->captured_pieces_count[captor]++] = generate_id_for_piece(expected_piece_types[type], color, piece_number);
 			}
-			b->captured_pieces_count[color] += expected_piece_count[color][type];
 		}
 	}
 }
@@ -198,6 +198,7 @@ typedef struct {
 	uint8_t square_table[8][8];
 
 	uint8_t castle_rights; // XBBBXWWW
+	uint8_t halfmove_clock; // plies since the last capture or pawn move (fifty move rule)
 
 	uint8_t captured_pieces[2][16];  // captured_pieces[WHITE], captured_piece[BLACK]
 	short captured_pieces_count[2];
@@ -228,6 +229,7 @@ typedef struct {
 // functions for chessboard
 void init_board(board *b);
 void init_pieces(pieces *type);
+void free_board(board *b);
 void print_board(board *b, short turn, short system);
 void load_fen(board *b, char *fen);
 
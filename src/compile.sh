@@ -1,7 +1,7 @@
 #!/bin/bash
 
 if ls *.c 1> /dev/null 2>&1; then
-    gcc $(ls *.c | grep -v 'perft.c') -lm -g -o chess
+    gcc $(ls *.c | grep -v -e 'perft.c' -e 'tests.c' -e 'benchmark.c' -e 'regression.c' -e 'scaling.c') -lm -pthread -g -o chess
 
     if [ $? -eq 0 ]; then
         echo "Compilation successful. Output file: chess"
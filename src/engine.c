@@ -4,6 +4,8 @@
 #include <stdlib.h>
 #include <string.h>
 #include <wchar.h>
+#include <pthread.h>
+#include <time.h>
 
 #include "chessboard.h"
 #include "move_stack.h"
@@ -14,6 +16,26 @@
 #include "transposition.h"
 #include "opening_book.h"
 
+_Thread_local search_stats engine_stats;
+
+// with a deadline the clock is read every 1024 nodes, a stopped search returns without storing anything
+typedef struct {
+	double deadline;  // wall clock time in ms, 0 -> no limit
+	bool stopped;
+	int null_move_min_ply;  // no null move before this ply, see the verification in negamax
+	int extensions;         // plies the current line has been extended by, see negamax
+	bool follow_pv;         // the next node is on the principal variation of the last iteration
+} search_control;
+
+static _Thread_local search_control control;
+
+// elapsed milliseconds of a monotonic clock, clock() would add up the cpu time of all threads
+double wall_time_ms() {
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return t.tv_sec * 1000.0 + t.tv_nsec / 1000000.0;
+}
+
 void swap(Move* a, Move* b) {
 	Move temp = *a;
 	*a = *b;
@@ -44,165 +66,1078 @@ void quick_sort(MoveList* list, int low, int high) {
 	}
 }
 
-evaluated_move minimax(board* b, int depth, short maximizing_player, double alpha, double beta) {
-	evaluated_move _move;
+static bool same_move(Move a, Move b) {
+	return a.src.file == b.src.file && a.src.rank == b.src.rank && a.dest.file == b.dest.file && a.dest.rank == b.dest.rank && a.type == b.type;
+}
+
+static int square_index(square s) {
+	return (s.rank - 1) * 8 + s.file - 1;
+}
+
+static bool is_quiet(Move m) {
+	return !m.captured_piece && !m.promoted_piece;
+}
+
+static bool is_promotion(Move m) {
+	return (m.type & PROMOTION_MOVE_MASK) == WHITE_PROMOTION_MOVE || (m.type & PROMOTION_MOVE_MASK) == BLACK_PROMOTION_MOVE;
+}
+
+// the moves of the transposition table only know src, dest and the promotion (see entry_move)
+static bool matches_table_move(Move m, Move table_move) {
+	if (table_move.src.file == 0) {
+		return false;
+	}
+	bool same_squares = m.src.file == table_move.src.file && m.src.rank == table_move.src.rank && m.dest.file == table_move.dest.file && m.dest.rank == table_move.dest.rank;
+	return same_squares && (!is_promotion(m) || m.type == table_move.type);
+}
+
+// killer moves and countermoves per thread, history per color and from/to square (butterfly table)
+// order: pv move, table move, captures (MVV-LVA), killers, countermove, history, losing captures
+typedef struct {
+	Move killers[MAX_PLY][2];
+	Move countermoves[64][64];
+	int history[2][64][64];
+} move_ordering;
+
+static _Thread_local move_ordering ordering;
+
+#define HISTORY_MAX 16384
+#define PV_MOVE_ORDER 5000000
+#define TABLE_MOVE_ORDER 4000000
+#define CAPTURE_ORDER 3000000
+#define KILLER_ORDER 2000000
+#define COUNTERMOVE_ORDER (KILLER_ORDER - 1)
+#define QUIET_ORDER 1000000  // losing captures are below
+
+void clear_move_ordering() {
+	memset(&ordering, 0, sizeof(ordering));
+}
+
+static Move countermove_of(Move previous) {
+	if (previous.src.file == 0) {
+		return PLACEHOLDER_MOVE;
+	}
+	return ordering.countermoves[square_index(previous.src)][square_index(previous.dest)];
+}
+
+// a capture of a piece worth at least the capturing one can't lose material, only the others need SEE
+static bool is_losing_capture(Move m, short turn, board* b) {
+	if (!m.captured_piece || m.promoted_piece || piece_type(m.piece) == KING) {
+		return false;
+	}
+	if (get_weight_from_piece_type(piece_type(m.captured_piece)) >= get_weight_from_piece_type(piece_type(m.piece))) {
+		return false;
+	}
+	return static_exchange_evaluation(m, turn, b) < 0;
+}
+
+// triangular PV table: pv_table[ply] is the best line from the node at 'ply',
+// the line of the last iteration is searched first while control.follow_pv is set
+_Thread_local pv_line engine_pv;
+static _Thread_local pv_line pv_table[MAX_PLY + 1];
+
+static void update_pv(int ply, Move m) {
+	if (ply >= MAX_PLY) {
+		return;
+	}
+	pv_line* child = &pv_table[ply + 1];
+	int length = child->length < MAX_PLY - 1 ? child->length : MAX_PLY - 1;
+	pv_table[ply].moves[0] = m;
+	memcpy(&pv_table[ply].moves[1], child->moves, sizeof(Move) * length);
+	pv_table[ply].length = length + 1;
+}
+
+// moves are picked lazily (selection sort), a picked move is marked PICKED in the scores
+#define PICKED INT_MIN
+
+// index of the best move not picked yet, -1 if all have been picked
+static int pick_move(int* scores, int num_moves) {
+	int best = -1;
+	for (int i = 0; i < num_moves; i++) {
+		if (scores[i] != PICKED && (best < 0 || scores[i] > scores[best])) {
+			best = i;
+		}
+	}
+	if (best >= 0) {
+		scores[best] = PICKED;
+	}
+	return best;
+}
+
+static void score_moves(Move* moves, int num_moves, short turn, int ply, Move previous, Move table_move, board* b) {
+	Move countermove = countermove_of(previous);
+	Move* killers = ply < MAX_PLY ? ordering.killers[ply] : NULL;
+
+	for (int i = 0; i < num_moves; i++) {
+		Move* m = &moves[i];
+		if (matches_table_move(*m, table_move)) {
+			m->score = TABLE_MOVE_ORDER;
+		} else if (!is_quiet(*m)) {
+			m->score += is_losing_capture(*m, turn, b) ? 0 : CAPTURE_ORDER;
+		} else if (killers && same_move(*m, killers[0])) {
+			m->score = KILLER_ORDER + 1;
+		} else if (killers && same_move(*m, killers[1])) {
+			m->score = KILLER_ORDER;
+		} else if (same_move(*m, countermove)) {
+			m->score = COUNTERMOVE_ORDER;
+		} else {
+			m->score += QUIET_ORDER + HISTORY_MAX + ordering.history[turn][square_index(m->src)][square_index(m->dest)];
+		}
+	}
+}
+
+static void update_history(int* value, int bonus) {
+	*value += bonus - *value * abs(bonus) / HISTORY_MAX;
+}
+
+// 'm' caused a beta cutoff, 'quiets' are the quiet moves searched before it
+static void update_move_ordering(Move m, Move* quiets, int num_quiets, short turn, int depth, int ply, Move previous) {
+	int bonus = depth * depth;
+	update_history(&ordering.history[turn][square_index(m.src)][square_index(m.dest)], bonus);
+	for (int i = 0; i < num_quiets; i++) {
+		update_history(&ordering.history[turn][square_index(quiets[i].src)][square_index(quiets[i].dest)], -bonus);
+	}
+
+	if (ply < MAX_PLY && !same_move(m, ordering.killers[ply][0])) {
+		ordering.killers[ply][1] = ordering.killers[ply][0];
+		ordering.killers[ply][0] = m;
+	}
+	if (previous.src.file != 0) {
+		ordering.countermoves[square_index(previous.src)][square_index(previous.dest)] = m;
+	}
+}
+
+// mates score MATE_SCORE - ply from the root, the table stores them relative to the position
+static bool is_mate_score(int score) {
+	return score >= MATE_BOUND || score <= -MATE_BOUND;
+}
+
+static int score_to_tt(int score, int ply) {
+	return score >= MATE_BOUND ? score + ply : score <= -MATE_BOUND ? score - ply : score;
+}
+
+static int score_from_tt(int score, int ply) {
+	return score >= MATE_BOUND ? score - ply : score <= -MATE_BOUND ? score + ply : score;
+}
+
+// keys of the game (record_position) followed by the keys of the current line, by ply;
+// a repetition is only looked for within the halfmove clock and after the last null move
+typedef struct {
+	uint64_t keys[MAX_GAME_PLY + MAX_PLY + 1];
+	int game_length;  // positions of the game before the root
+	int null_ply;     // ply of the position after the last null move of the current line, 0 if none
+} position_history;
+
+static _Thread_local position_history history;
+
+// 'key' is the zobrist key of a position played, with the side to move, see get_zobrist_key
+void record_position(uint64_t key) {
+	if (history.game_length < MAX_GAME_PLY) {
+		history.keys[history.game_length++] = key;
+	}
+}
+
+void clear_position_history() {
+	history.game_length = 0;
+}
+
+// stores the key of the node at 'ply' of the current line
+static void push_position(uint64_t key, int ply) {
+	if (ply <= MAX_PLY) {
+		history.keys[history.game_length + ply] = key;
+	}
+}
+
+// the position at 'ply' (stored with push_position) occurred before
+bool is_repetition(board* b, uint64_t key, int ply) {
+	if (ply > MAX_PLY) {
+		return false;
+	}
+	int index = history.game_length + ply;
+	int oldest = index - b->halfmove_clock;
+	if (history.null_ply && oldest < history.game_length + history.null_ply) {
+		oldest = history.game_length + history.null_ply;
+	}
+	for (int i = index - 4; i >= oldest && i >= 0; i -= 2) {
+		if (history.keys[i] == key) {
+			return true;
+		}
+	}
+	return false;
+}
+
+bool insufficient_material(board* b) {
+	int minor_pieces = 0;
+	for (short color = WHITE; color <= BLACK; color++) {
+		if (pieces_of_type(b, color, PAWN) | pieces_of_type(b, color, ROOK) | pieces_of_type(b, color, QUEEN)) {
+			return false;
+		}
+		minor_pieces += __builtin_popcountll(pieces_of_type(b, color, KNIGHT) | pieces_of_type(b, color, BISHOP));
+	}
+	return minor_pieces <= 1;
+}
+
+// captures and promotions until the position is quiet: stand pat, delta pruning, SEE
+static int quiescence(board* b, int ply, short turn, int alpha, int beta) {
+	engine_stats.nodes++;
+	engine_stats.qnodes++;
+
+	if (control.deadline && (engine_stats.nodes & 1023) == 0 && wall_time_ms() >= control.deadline) {
+		control.stopped = true;
+	}
+	if (control.stopped) {
+		return 0;
+	}
+	if (insufficient_material(b)) {
+		return DRAW_SCORE;
+	}
+
+	bool in_check = checkers(turn, b) != 0;
+	int stand_pat = turn == WHITE ? get_evaluation_of_board(b) : -get_evaluation_of_board(b);
+	if (!in_check) {
+		if (stand_pat >= beta) {
+			return stand_pat;
+		}
+		alpha = alpha > stand_pat ? alpha : stand_pat;
+	}
+
+	MoveList* legal_moves = turn == WHITE ? b->white_legal_moves : b->black_legal_moves;
+	clear_move_list(b->white_attacks);
+	clear_move_list(b->black_attacks);
+	clear_move_list(legal_moves);
+	update_attacks_for_color(b, !turn);
+	update_attacks_for_color(b, turn);
+	filter_legal_moves(b, turn);
+
+	int num_legal_moves = legal_moves->move_count;
+	if (in_check && num_legal_moves == 0) {
+		return -MATE_SCORE + ply;
+	}
+
+	Move legal_moves_bk[num_legal_moves];
+	memcpy(legal_moves_bk, legal_moves->moves, sizeof(Move) * num_legal_moves);
+
+	// the moves worth searching, picked best exchange first
+	Move moves[num_legal_moves];
+	int gains[num_legal_moves], num_moves = 0;
+	for (int i = 0; i < num_legal_moves; i++) {
+		Move m = legal_moves_bk[i];
+		if (!m.captured_piece && !m.promoted_piece && !in_check) {
+			continue;
+		}
+
+		int gain = m.captured_piece ? get_weight_from_piece_type(piece_type(m.captured_piece)) : 0;
+		if (m.promoted_piece) {
+			gain += get_weight_from_piece_type(piece_type_from_promotion_flag(m.type)) - get_weight_from_piece_type(PAWN);
+		}
+		if (!in_check && stand_pat + gain + DELTA_MARGIN <= alpha) {
+			continue;
+		}
+		if (m.captured_piece && !m.promoted_piece) {
+			gain = static_exchange_evaluation(m, turn, b);
+			if (!in_check && gain < 0) {
+				continue;
+			}
+		}
+
+		moves[num_moves] = m;
+		gains[num_moves++] = gain;
+	}
+
+	uint64_t lookup_table_bk[97], *lookup_table_ptr;
+	lookup_table_ptr = turn == WHITE ? b->white_lookup_table : b->black_lookup_table;
+	memcpy(lookup_table_bk, lookup_table_ptr, sizeof(uint64_t) * 97);
+	uint64_t white_board_bk = b->white_board;
+	uint64_t black_board_bk = b->black_board;
+
+	int best = in_check ? -MATE_SCORE + ply : stand_pat;
+	for (int i = pick_move(gains, num_moves); i >= 0; i = pick_move(gains, num_moves)) {
+		Move m = moves[i];
+
+		memcpy(legal_moves->moves, legal_moves_bk, sizeof(Move) * num_legal_moves);
+		legal_moves->move_count = num_legal_moves;
+		memcpy(lookup_table_ptr, lookup_table_bk, sizeof(uint64_t) * 97);
+		b->white_board = white_board_bk;
+		b->black_board = black_board_bk;
+
+		if (make_move(m.src, m.dest, turn, b, true, m.type) == INVALID_MOVE) {
+			continue;
+		}
+		int score = -quiescence(b, ply + 1, !turn, -beta, -alpha);
+		unmake_move(b);
+		if (control.stopped) {
+			break;
+		}
+
+		if (score > best) {
+			best = score;
+		}
+		if (score > alpha) {
+			alpha = score;
+		}
+		if (alpha >= beta) {
+			break;
+		}
+	}
+
+	memcpy(lookup_table_ptr, lookup_table_bk, sizeof(uint64_t) * 97);
+	b->white_board = white_board_bk;
+	b->black_board = black_board_bk;
+	return best;
+}
+
+// log(depth) * log(move number), adjusted by history; tactical, killer and check moves aren't reduced
+static int reductions[MAX_SEARCH_DEPTH + 1][MAX_MOVES];
+static pthread_once_t reductions_once = PTHREAD_ONCE_INIT;
+
+static void init_reductions() {
+	for (int depth = 1; depth <= MAX_SEARCH_DEPTH; depth++) {
+		for (int i = 1; i < MAX_MOVES; i++) {
+			reductions[depth][i] = (int)(LMR_BASE + log(depth) * log(i) / LMR_DIVISOR);
+		}
+	}
+}
+
+// 'searched' is the number of moves searched before 'm'
+static int late_move_reduction(Move m, int depth, int searched, short turn, bool in_check, bool gives_check) {
+	if (depth < LMR_MIN_DEPTH || searched < LMR_MIN_MOVES || in_check || gives_check || !is_quiet(m) || m.score >= COUNTERMOVE_ORDER) {
+		return 0;
+	}
+	pthread_once(&reductions_once, init_reductions);
+
+	int reduction = reductions[depth < MAX_SEARCH_DEPTH ? depth : MAX_SEARCH_DEPTH][searched < MAX_MOVES ? searched : MAX_MOVES - 1];
+	reduction -= ordering.history[turn][square_index(m.src)][square_index(m.dest)] / (HISTORY_MAX / 2);
+	if (reduction > depth - 2) {
+		reduction = depth - 2;
+	}
+	return reduction > 0 ? reduction : 0;
+}
+
+// reverse futility pruning, razoring and futility pruning: not at the root, in check or near mate scores
+static bool can_prune(int ply, bool in_check, int alpha, int beta) {
+	return ply > 0 && !in_check && alpha > -MATE_BOUND && beta < MATE_BOUND;
+}
+
+// a capture which beats beta + PROBCUT_MARGIN with PROBCUT_REDUCTION plies less depth cuts the node,
+// returns its score or -INFINITE_SCORE
+static int probcut(board* b, int depth, int ply, short turn, int beta, int static_evaluation, uint64_t key) {
+	int probcut_beta = beta + PROBCUT_MARGIN;
+	int probcut_depth = depth - PROBCUT_REDUCTION;
+
+	MoveList* legal_moves = turn == WHITE ? b->white_legal_moves : b->black_legal_moves;
+	clear_move_list(b->white_attacks);
+	clear_move_list(b->black_attacks);
+	clear_move_list(legal_moves);
+	update_attacks_for_color(b, !turn);
+	update_attacks_for_color(b, turn);
+	filter_legal_moves(b, turn);
+
+	int num_legal_moves = legal_moves->move_count;
+	Move legal_moves_bk[num_legal_moves];
+	memcpy(legal_moves_bk, legal_moves->moves, sizeof(Move) * num_legal_moves);
+
+	Move captures[num_legal_moves];
+	int num_captures = 0;
+	for (int i = 0; i < num_legal_moves; i++) {
+		Move m = legal_moves_bk[i];
+		if (m.captured_piece && static_exchange_evaluation(m, turn, b) >= probcut_beta - static_evaluation) {
+			captures[num_captures++] = m;
+		}
+	}
+
+	uint64_t lookup_table_bk[97], *lookup_table_ptr;
+	lookup_table_ptr = turn == WHITE ? b->white_lookup_table : b->black_lookup_table;
+	memcpy(lookup_table_bk, lookup_table_ptr, sizeof(uint64_t) * 97);
+	uint64_t white_board_bk = b->white_board;
+	uint64_t black_board_bk = b->black_board;
+
+	int result = -INFINITE_SCORE;
+	for (int i = 0; i < num_captures; i++) {
+		memcpy(legal_moves->moves, legal_moves_bk, sizeof(Move) * num_legal_moves);
+		legal_moves->move_count = num_legal_moves;
+		memcpy(lookup_table_ptr, lookup_table_bk, sizeof(uint64_t) * 97);
+		b->white_board = white_board_bk;
+		b->black_board = black_board_bk;
+
+		Move m = captures[i];
+		if (make_move(m.src, m.dest, turn, b, true, m.type) == INVALID_MOVE) {
+			continue;
+		}
+		int score = -quiescence(b, ply + 1, !turn, -probcut_beta, -probcut_beta + NULL_WINDOW);
+		if (score >= probcut_beta && !control.stopped) {
+			score = -negamax(b, probcut_depth - 1, ply + 1, !turn, -probcut_beta, -probcut_beta + NULL_WINDOW, PLACEHOLDER_MOVE).evaluation;
+		}
+		unmake_move(b);
+		if (control.stopped) {
+			break;
+		}
+
+		if (score >= probcut_beta) {
+			insert_entry(&transposition_table, key, m, score_to_tt(score, ply), probcut_depth, BOUND_LOWER);
+			result = score;
+			break;
+		}
+	}
+
+	memcpy(lookup_table_ptr, lookup_table_bk, sizeof(uint64_t) * 97);
+	b->white_board = white_board_bk;
+	b->black_board = black_board_bk;
+	return result;
+}
+
+// the table move is extended if no other move gets near its score, another move above beta cuts
+static bool singular_search_allowed(int depth, int ply, Move excluded, Move table_move, int table_score, int table_depth, uint8_t table_bound) {
+	if (ply == 0 || depth < SINGULAR_MIN_DEPTH || excluded.src.file || !table_move.src.file) {
+		return false;
+	}
+	if (table_depth < depth - SINGULAR_DEPTH_MARGIN || (table_bound != BOUND_LOWER && table_bound != BOUND_EXACT)) {
+		return false;
+	}
+	return !is_mate_score(table_score);
+}
+
+// no null move in check, with pawns only, after a null move or before control.null_move_min_ply;
+// deep cutoffs are verified with a reduced search of the node
+static bool null_move_allowed(board* b, int depth, int ply, short turn, int beta, Move previous, bool can_prune, int static_evaluation) {
+	if (!can_prune || ply < control.null_move_min_ply || depth < NULL_MOVE_MIN_DEPTH || beta >= MATE_BOUND) {
+		return false;
+	}
+	if (previous.type == PASS_MOVE || static_evaluation < beta) {
+		return false;
+	}
+	uint64_t non_pawn_material = pieces_of_type(b, turn, KNIGHT) | pieces_of_type(b, turn, BISHOP) | pieces_of_type(b, turn, ROOK) | pieces_of_type(b, turn, QUEEN);
+	return non_pawn_material != 0;
+}
+
+// returns the null move score, >= beta -> the node can be cut
+static int null_move_search(board* b, int depth, int ply, short turn, int beta) {
+	int reduction = depth > 6 ? 3 : 2;
+	int null_depth = depth - 1 - reduction > 0 ? depth - 1 - reduction : 0;
+
+	int null_ply = history.null_ply;
+	history.null_ply = ply + 1;
+	make_null_move(b);
+	int score = -negamax(b, null_depth, ply + 1, !turn, -beta, -beta + NULL_WINDOW, PLACEHOLDER_MOVE).evaluation;
+	unmake_move(b);
+	history.null_ply = null_ply;
+
+	if (control.stopped || score < beta) {
+		return score;
+	}
+	// a mate found after passing isn't proven
+	score = score >= MATE_BOUND ? beta : score;
+	if (depth < NULL_MOVE_VERIFICATION_DEPTH) {
+		return score;
+	}
+
+	int min_ply = control.null_move_min_ply;
+	control.null_move_min_ply = ply + 3 * (depth - reduction) / 4;
+	int verification = negamax(b, depth - reduction, ply, turn, beta - NULL_WINDOW, beta, PLACEHOLDER_MOVE).evaluation;
+	control.null_move_min_ply = min_ply;
+	return verification >= beta ? score : verification;
+}
+
+// fail-soft principal variation search, scores from the point of view of the side to move
+evaluated_move negamax(board* b, int depth, int ply, short turn, int alpha, int beta, Move excluded) {
+	evaluated_move _move = {0, PLACEHOLDER_MOVE};  // a stopped search returns it as it is
+	if (ply <= MAX_PLY) {
+		pv_table[ply].length = 0;
+	}
+	bool on_pv = control.follow_pv;
+	control.follow_pv = false;
+
 	if (depth == 0) {
-		_move.evaluation = get_evaluation_of_board(b);
-		_move.best_move = PLACEHOLDER_MOVE;
+		_move.evaluation = quiescence(b, ply, turn, alpha, beta);
 		return _move;
 	}
 
+	engine_stats.nodes++;
+	if (control.deadline && (engine_stats.nodes & 1023) == 0 && wall_time_ms() >= control.deadline) {
+		control.stopped = true;
+	}
+	if (control.stopped) {
+		_move.evaluation = 0;
+		return _move;
+	}
+
+	// draws by repetition, the fifty move rule or insufficient material (not at the root, it
+	// has to return a move)
+	uint64_t key = get_zobrist_key(b, &transposition_table, turn);
+	push_position(key, ply);
+	if (ply > 0 && (is_repetition(b, key, ply) || b->halfmove_clock >= 100 || insufficient_material(b))) {
+		_move.evaluation = DRAW_SCORE;
+		return _move;
+	}
+
+	// mate distance pruning: nothing from here is better than mating with the next move or worse
+	// than being mated now, if a shorter mate is known already, the node can't improve on it
+	if (ply > 0) {
+		alpha = alpha > -MATE_SCORE + ply ? alpha : -MATE_SCORE + ply;
+		beta = beta < MATE_SCORE - ply - 1 ? beta : MATE_SCORE - ply - 1;
+		if (alpha >= beta) {
+			_move.evaluation = alpha;
+			return _move;
+		}
+	}
+
 	// check opening book
-	Move book_move = get_book_move(&opening_book, b, maximizing_player);
+	Move book_move = get_book_move(&opening_book, b, turn);
 	if (book_move.src.file != 0) {
 		_move.evaluation = 0;
 		_move.best_move = book_move;
 		return _move;
 	}
 
-	// check the transposition table
-	uint64_t key = get_zobrist_key(b, &transposition_table, maximizing_player);
-	Entry* entry = get_entry(&transposition_table, key);
+	// check the transposition table, a bound only decides the node if it is outside the window
+	// (not in the search of the other moves of a singular extension, the entry is of all moves)
+	Entry entry;
+	Move table_move = PLACEHOLDER_MOVE;
+	int table_score = 0;
+	int table_depth = 0;
+	uint8_t table_bound = BOUND_NONE;
 
-	if (entry && entry->key && entry->depth >= depth) {
-		_move.evaluation = entry->evaluation;
-		_move.best_move = entry->best_move;
+	if (!excluded.src.file && get_entry(&transposition_table, key, &entry)) {
+		table_move = entry_move(&entry, turn);
+		table_score = score_from_tt(entry_score(&entry), ply);
+		table_depth = entry.depth;
+		table_bound = entry_bound(&entry);
+		if (table_depth >= depth && bound_cutoff(table_bound, table_score, alpha, beta)) {
+			_move.evaluation = table_score;
+			_move.best_move = table_move;
+			return _move;
+		}
+	}
+
+	Move previous = b->moves->top ? b->moves->top->move : PLACEHOLDER_MOVE;
+	bool in_check = checkers(turn, b) != 0;
+	int static_evaluation = in_check ? 0 : turn == WHITE ? get_evaluation_of_board(b) : -get_evaluation_of_board(b);
+	bool pruning = !excluded.src.file && can_prune(ply, in_check, alpha, beta);
+
+	if (pruning && depth <= RFP_DEPTH && static_evaluation - RFP_MARGIN * depth >= beta) {
+		_move.evaluation = static_evaluation;
 		return _move;
 	}
+	if (pruning && depth <= RAZOR_DEPTH && static_evaluation + RAZOR_MARGIN * depth <= alpha) {
+		int score = quiescence(b, ply, turn, alpha, alpha + NULL_WINDOW);
+		if (control.stopped || score <= alpha) {
+			_move.evaluation = score;
+			return _move;
+		}
+	}
+	bool futile = pruning && depth <= FUTILITY_DEPTH && static_evaluation + FUTILITY_MARGIN * depth <= alpha;
+
+	if (null_move_allowed(b, depth, ply, turn, beta, previous, pruning, static_evaluation)) {
+		int score = null_move_search(b, depth, ply, turn, beta);
+		if (control.stopped) {
+			return _move;
+		}
+		if (score >= beta) {
+			_move.evaluation = score;
+			return _move;
+		}
+	}
 
+	// internal iterative reduction: without a move from the table the move ordering is poor and a
+	// full depth search of this node is expensive, the shallower search gives the next visit a move
+	if (ply > 0 && !excluded.src.file && !table_move.src.file && depth >= IIR_MIN_DEPTH) {
+		depth--;
+	}
+
+	// ProbCut, unless the table already knows that the reduced search doesn't reach the bound
+	bool pv_node = beta - alpha > NULL_WINDOW;
+	if (pruning && !pv_node && depth >= PROBCUT_MIN_DEPTH && beta + PROBCUT_MARGIN < MATE_BOUND &&
+	    !(table_depth >= depth - PROBCUT_REDUCTION && table_score < beta + PROBCUT_MARGIN && table_bound != BOUND_NONE)) {
+		int score = probcut(b, depth, ply, turn, beta, static_evaluation, key);
+		if (control.stopped) {
+			return _move;
+		}
+		if (score >= beta + PROBCUT_MARGIN) {
+			_move.evaluation = score;
+			return _move;
+		}
+	}
 
-	// Step 1: Select the correct move list based on the turn
-	MoveList* pseudo_legal_moves = maximizing_player == WHITE ? b->white_attacks : b->black_attacks;
-	MoveList* legal_moves = maximizing_player == WHITE ? b->white_legal_moves : b->black_legal_moves;
+	bool singular = false;
+	if (singular_search_allowed(depth, ply, excluded, table_move, table_score, table_depth, table_bound)) {
+		int singular_beta = table_score - SINGULAR_MARGIN * depth;
+		int score = negamax(b, (depth - 1) / 2, ply, turn, singular_beta - NULL_WINDOW, singular_beta, table_move).evaluation;
+		if (control.stopped) {
+			return _move;
+		}
+		if (score < singular_beta) {
+			singular = true;
+		} else if (singular_beta >= beta) {
+			// multi-cut: the table move and at least one other move fail high
+			_move.evaluation = singular_beta;
+			return _move;
+		}
+	}
 
-	// Step 2: Clear the pseudo-legal and legal move lists before generating moves
-	pseudo_legal_moves->move_count = 0;
-	legal_moves->move_count = 0;
+	MoveList* pseudo_legal_moves = turn == WHITE ? b->white_attacks : b->black_attacks;
+	MoveList* legal_moves = turn == WHITE ? b->white_legal_moves : b->black_legal_moves;
 
 	clear_move_list(pseudo_legal_moves);
 	clear_move_list(legal_moves);
 
-	// update_attacks(b);
-
 	b->black_attacks->move_count = 0;
-	update_attacks_for_color(b, !maximizing_player);
+	update_attacks_for_color(b, !turn);
 	b->white_attacks->move_count = 0;
-	update_attacks_for_color(b, maximizing_player);
+	update_attacks_for_color(b, turn);
 
-	filter_legal_moves(b, maximizing_player);
+	filter_legal_moves(b, turn);
 
 	int num_legal_moves = legal_moves->move_count;
 
-	// Sort the legal moves based on their scores
-	quick_sort(legal_moves, 0, num_legal_moves - 1);
+	// score the legal moves, they are searched in the order of their scores (pick_move)
+	score_moves(legal_moves->moves, num_legal_moves, turn, ply, previous, table_move, b);
+	Move pv_move = on_pv && ply < engine_pv.length ? engine_pv.moves[ply] : PLACEHOLDER_MOVE;
+	int scores[num_legal_moves];
+	for (int i = 0; i < num_legal_moves; i++) {
+		if (on_pv && same_move(legal_moves->moves[i], pv_move)) {
+			legal_moves->moves[i].score = PV_MOVE_ORDER;
+		}
+		scores[i] = legal_moves->moves[i].score;
+	}
 
 	// Backup essential elements in board state
 	Move legal_moves_bk[num_legal_moves];
 	memcpy(legal_moves_bk, legal_moves->moves, sizeof(Move) * num_legal_moves);
 
 	uint64_t lookup_table_bk[97], *lookup_table_ptr;
-
-	if (maximizing_player == WHITE) {
-		lookup_table_ptr = b->white_lookup_table;
-		memcpy(lookup_table_bk, b->white_lookup_table, sizeof(uint64_t) * 97);
-	} else {
-		lookup_table_ptr = b->black_lookup_table;
-		memcpy(lookup_table_bk, b->black_lookup_table, sizeof(uint64_t) * 97);
-	}
+	lookup_table_ptr = turn == WHITE ? b->white_lookup_table : b->black_lookup_table;
+	memcpy(lookup_table_bk, lookup_table_ptr, sizeof(uint64_t) * 97);
 	uint64_t white_board_bk = b->white_board;
 	uint64_t black_board_bk = b->black_board;
 
-	if (maximizing_player == WHITE) {
-		double max_eval = INT_MIN;
-		for (int i = 0; i < num_legal_moves; i++) {
-			memcpy(legal_moves->moves, legal_moves_bk, sizeof(Move) * num_legal_moves);
-			memcpy(lookup_table_ptr, lookup_table_bk, sizeof(uint64_t) * 97);
-			b->white_board = white_board_bk;
-			b->black_board = black_board_bk;
+	int alpha_orig = alpha;
+	int best = -INFINITE_SCORE;
+	int searched = 0;
+	if (ply <= MAX_PLY) {
+		pv_table[ply].length = 0;  // the searches before the moves (singular, null move) may have left a line
+	}
+	Move quiets[num_legal_moves];
+	int num_quiets = 0;
 
-			Move m = legal_moves->moves[i];
+	for (int i = pick_move(scores, num_legal_moves); i >= 0; i = pick_move(scores, num_legal_moves)) {
+		memcpy(legal_moves->moves, legal_moves_bk, sizeof(Move) * num_legal_moves);
+		memcpy(lookup_table_ptr, lookup_table_bk, sizeof(uint64_t) * 97);
+		b->white_board = white_board_bk;
+		b->black_board = black_board_bk;
 
-			square src = {
-			    .file = m.src.file,
-			    .rank = m.src.rank};
-			square dest = {
-			    .file = m.dest.file,
-			    .rank = m.dest.rank};
+		Move m = legal_moves_bk[i];
+		if (matches_table_move(m, excluded)) {
+			continue;
+		}
+		if (make_move(m.src, m.dest, turn, b, true, m.type) == INVALID_MOVE) {
+			continue;
+		}
+		bool gives_check = checkers(!turn, b) != 0;
+		if (futile && searched > 0 && is_quiet(m) && !gives_check) {
+			unmake_move(b);
+			best = best > static_evaluation + FUTILITY_MARGIN * depth ? best : static_evaluation + FUTILITY_MARGIN * depth;
+			continue;
+		}
 
-			short status = make_move(src, dest, maximizing_player, b, true, m.type);
+		// check and singular extension, as long as the line has some of its budget left
+		bool extend = gives_check || (singular && matches_table_move(m, table_move));
+		int extension = extend && control.extensions < MAX_EXTENSIONS ? 1 : 0;
+		int new_depth = depth - 1 + extension;
+		control.extensions += extension;
 
-			if (status == INVALID_MOVE) {
-				continue;
+		int score;
+		control.follow_pv = on_pv && same_move(m, pv_move);
+		if (searched == 0) {
+			score = -negamax(b, new_depth, ply + 1, !turn, -beta, -alpha, PLACEHOLDER_MOVE).evaluation;
+		} else {
+			int reduction = late_move_reduction(m, depth, searched, turn, in_check, gives_check);
+			score = -negamax(b, new_depth - reduction, ply + 1, !turn, -alpha - NULL_WINDOW, -alpha, PLACEHOLDER_MOVE).evaluation;
+			if (reduction && score > alpha && !control.stopped) {
+				score = -negamax(b, new_depth, ply + 1, !turn, -alpha - NULL_WINDOW, -alpha, PLACEHOLDER_MOVE).evaluation;
 			}
-			evaluated_move eval = minimax(b, depth - 1, BLACK, alpha, beta);
-			
-			// insert entry in transposition table
-			Entry e = {
-				.key = key,
-				.evaluation = eval.evaluation,
-				.depth = depth,
-				.best_move = m,
-				.alpha = alpha,
-				.beta = beta
-			};
-			insert_entry(&transposition_table, e);
+			if (score > alpha && score < beta && !control.stopped) {
+				score = -negamax(b, new_depth, ply + 1, !turn, -beta, -alpha, PLACEHOLDER_MOVE).evaluation;
+			}
+		}
+		control.extensions -= extension;
+		unmake_move(b);
+		searched++;
 
+		if (control.stopped) {
+			return _move;
+		}
 
-			unmake_move(b);
-			if (eval.evaluation > max_eval) {
-				max_eval = eval.evaluation;
-				_move.best_move = m;
+		if (score > best) {
+			best = score;
+			_move.best_move = m;
+		}
+		if (score > alpha) {
+			alpha = score;
+			update_pv(ply, m);
+		}
+		if (alpha >= beta) {
+			engine_stats.cutoffs++;
+			engine_stats.first_move_cutoffs += searched == 1;
+			if (is_quiet(m)) {
+				update_move_ordering(m, quiets, num_quiets, turn, depth, ply, previous);
 			}
+			break;
+		}
+		if (is_quiet(m)) {
+			quiets[num_quiets++] = m;
+		}
+	}
 
-			alpha = alpha > eval.evaluation ? alpha : eval.evaluation;
+	memcpy(lookup_table_ptr, lookup_table_bk, sizeof(uint64_t) * 97);
+	b->white_board = white_board_bk;
+	b->black_board = black_board_bk;
 
-			if (beta <= alpha) {
-				break;
+	// no legal moves: mated or stalemated
+	if (num_legal_moves == 0) {
+		best = in_check ? -MATE_SCORE + ply : DRAW_SCORE;
+	}
+
+	// the result without the excluded move isn't the one of the position. When all moves failed
+	// low, the best of them is just the least bad guess, the move an earlier search stored is kept
+	if (!excluded.src.file) {
+		uint8_t bound = best <= alpha_orig ? BOUND_UPPER : best >= beta ? BOUND_LOWER : BOUND_EXACT;
+		Move table_result = bound == BOUND_UPPER ? PLACEHOLDER_MOVE : _move.best_move;
+		insert_entry(&transposition_table, key, table_result, score_to_tt(best, ply), depth, bound);
+	}
+
+	_move.evaluation = best;
+	return _move;
+}
+
+// negamax with the score from white's point of view (positive -> white is better)
+evaluated_move minimax(board* b, int depth, short maximizing_player, int alpha, int beta) {
+	if (maximizing_player == WHITE) {
+		return negamax(b, depth, 0, WHITE, alpha, beta, PLACEHOLDER_MOVE);
+	}
+	evaluated_move eval = negamax(b, depth, 0, BLACK, -beta, -alpha, PLACEHOLDER_MOVE);
+	eval.evaluation = -eval.evaluation;
+	return eval;
+}
+
+// principal variation search of the root moves from moves[first] on with the window (alpha, beta),
+// the score is from the point of view of 'turn'
+static evaluated_move search_root(board* b, int depth, short turn, Move* moves, int num_moves, int first, int alpha, int beta) {
+	MoveList* legal_moves = turn == WHITE ? b->white_legal_moves : b->black_legal_moves;
+	uint64_t lookup_table_bk[97], *lookup_table_ptr;
+	lookup_table_ptr = turn == WHITE ? b->white_lookup_table : b->black_lookup_table;
+	memcpy(lookup_table_bk, lookup_table_ptr, sizeof(uint64_t) * 97);
+	uint64_t white_board_bk = b->white_board;
+	uint64_t black_board_bk = b->black_board;
+
+	evaluated_move best = {-INFINITE_SCORE, PLACEHOLDER_MOVE};
+	push_position(get_zobrist_key(b, &transposition_table, turn), 0);
+	pv_table[0].length = 0;
+
+	for (int i = first; i < num_moves; i++) {
+		memcpy(legal_moves->moves, moves, sizeof(Move) * num_moves);
+		legal_moves->move_count = num_moves;
+		memcpy(lookup_table_ptr, lookup_table_bk, sizeof(uint64_t) * 97);
+		b->white_board = white_board_bk;
+		b->black_board = black_board_bk;
+
+		Move m = moves[i];
+		if (make_move(m.src, m.dest, turn, b, true, m.type) == INVALID_MOVE) {
+			continue;
+		}
+		int score;
+		control.follow_pv = engine_pv.length > 0 && same_move(m, engine_pv.moves[0]);
+		if (!best.best_move.piece) {
+			score = -negamax(b, depth - 1, 1, !turn, -beta, -alpha, PLACEHOLDER_MOVE).evaluation;
+		} else {
+			score = -negamax(b, depth - 1, 1, !turn, -alpha - NULL_WINDOW, -alpha, PLACEHOLDER_MOVE).evaluation;
+			if (score > alpha && score < beta && !control.stopped) {
+				score = -negamax(b, depth - 1, 1, !turn, -beta, -alpha, PLACEHOLDER_MOVE).evaluation;
 			}
 		}
-		_move.evaluation = max_eval;
-		return _move;
+		unmake_move(b);
+		if (control.stopped) {
+			break;
+		}
+
+		if (!best.best_move.piece || score > best.evaluation) {
+			best.evaluation = score;
+			best.best_move = m;
+			update_pv(0, m);
+		}
+		alpha = alpha > score ? alpha : score;
+		if (alpha >= beta) {
+			break;
+		}
+	}
+
+	memcpy(legal_moves->moves, moves, sizeof(Move) * num_moves);
+	legal_moves->move_count = num_moves;
+	memcpy(lookup_table_ptr, lookup_table_bk, sizeof(uint64_t) * 97);
+	b->white_board = white_board_bk;
+	b->black_board = black_board_bk;
+	return best;
+}
+
+// root moves from moves[first] on, aspiration window around 'previous' (delta <= 0 -> full window)
+static evaluated_move aspiration_search(board* b, int depth, short turn, Move* moves, int num_moves, int first, int previous, int delta) {
+	int alpha = -INFINITE_SCORE, beta = INFINITE_SCORE;
+	if (delta > 0) {
+		alpha = previous - delta;
+		beta = previous + delta;
+	}
+
+	evaluated_move eval;
+	while (true) {
+		eval = search_root(b, depth, turn, moves, num_moves, first, alpha, beta);
+		engine_stats.root_searches++;
+		if (control.stopped) {
+			break;
+		}
+		if (eval.evaluation <= alpha && alpha > -INFINITE_SCORE) {
+			engine_stats.fail_lows++;
+			alpha = delta >= ASPIRATION_MAX_DELTA || eval.evaluation - delta < -INFINITE_SCORE ? -INFINITE_SCORE : eval.evaluation - delta;
+		} else if (eval.evaluation >= beta && beta < INFINITE_SCORE) {
+			engine_stats.fail_highs++;
+			beta = delta >= ASPIRATION_MAX_DELTA || eval.evaluation + delta > INFINITE_SCORE ? INFINITE_SCORE : eval.evaluation + delta;
+		} else {
+			break;
+		}
+		delta *= 2;
+	}
+
+	if (control.stopped && !(eval.best_move.piece && eval.evaluation > alpha)) {
+		eval.best_move = PLACEHOLDER_MOVE;
+	}
+	return eval;
+}
+
+// one line of output per iteration and line (0 -> the only one), the score from white's point of view
+static void print_line(int depth, int line, int score, unsigned long long nodes, double time, pv_line* pv) {
+	wchar_t text[32];
+	if (is_mate_score(score)) {
+		int moves = (MATE_SCORE - abs(score) + 1) / 2;
+		swprintf(text, 32, L"mate %d", score > 0 ? moves : -moves);
 	} else {
-		double min_eval = INT_MAX;
-		for (int i = 0; i < num_legal_moves; i++) {
-			memcpy(legal_moves->moves, legal_moves_bk, sizeof(Move) * num_legal_moves);
-			memcpy(lookup_table_ptr, lookup_table_bk, sizeof(uint64_t) * 97);	
-
-			Move m = legal_moves->moves[i];
-
-			square src = {
-			    .file = m.src.file,
-			    .rank = m.src.rank};
-			square dest = {
-			    .file = m.dest.file,
-			    .rank = m.dest.rank};
-
-			short status = make_move(src, dest, maximizing_player, b, true, m.type);
-			if (status == INVALID_MOVE) {
-				continue;
+		swprintf(text, 32, L"%.2lf", (double)score / PAWN_VALUE);
+	}
+
+	wprintf(L"depth %2d  ", depth);
+	if (line > 0) {
+		wprintf(L"multipv %d  ", line);
+	}
+	wprintf(L"eval %8ls  nodes %10llu  time %8.0lfms  pv", text, nodes, time);
+	for (int i = 0; i < pv->length; i++) {
+		Move m = pv->moves[i];
+		wprintf(L" %c%d%c%d", m.src.file + 'a' - 1, m.src.rank, m.dest.file + 'a' - 1, m.dest.rank);
+	}
+	wprintf(L"\n");
+}
+
+// deepens while the next iteration is expected to finish in time (effective branching factor),
+// aspiration windows from ASPIRATION_MIN_DEPTH on, limits.multi_pv lines per iteration
+evaluated_move iterative_deepening(board* b, short turn, search_limits limits) {
+	double start = wall_time_ms();
+	new_search(&transposition_table);
+	clear_move_ordering();
+	evaluated_move result = {0, PLACEHOLDER_MOVE};
+	engine_stats.depth = 0;
+	engine_pv.length = 0;
+
+	double budget, hard_limit;
+	if (limits.move_time > 0) {
+		budget = hard_limit = limits.move_time;
+	} else {
+		int moves_to_go = limits.moves_to_go > 0 ? limits.moves_to_go : DEFAULT_MOVES_TO_GO;
+		budget = limits.time_left / moves_to_go + limits.increment * 0.75;
+		hard_limit = fmin(budget * 3, limits.time_left / 2);
+		budget = fmin(budget, hard_limit);
+	}
+	int max_depth = limits.max_depth > 0 ? limits.max_depth : MAX_SEARCH_DEPTH;
+	int aspiration_delta = limits.aspiration_delta != 0 ? limits.aspiration_delta : ASPIRATION_DELTA;
+
+	Move book_move = get_book_move(&opening_book, b, turn);
+	if (book_move.src.file != 0) {
+		result.best_move = book_move;
+		return result;
+	}
+
+	MoveList* legal_moves = turn == WHITE ? b->white_legal_moves : b->black_legal_moves;
+	clear_move_list(b->white_attacks);
+	clear_move_list(b->black_attacks);
+	clear_move_list(legal_moves);
+	update_attacks_for_color(b, !turn);
+	update_attacks_for_color(b, turn);
+	filter_legal_moves(b, turn);
+
+	int num_moves = legal_moves->move_count;
+	if (num_moves == 0) {
+		return result;
+	}
+	quick_sort(legal_moves, 0, num_moves - 1);
+	Move root_moves[num_moves];
+	memcpy(root_moves, legal_moves->moves, sizeof(Move) * num_moves);
+	result.best_move = root_moves[0];  // something to play even if there is no time at all
+	int lines = limits.multi_pv > 1 ? (limits.multi_pv < num_moves ? limits.multi_pv : num_moves) : 1;
+	int line_scores[lines];  // of the last iteration, from the point of view of 'turn'
+	memset(line_scores, 0, sizeof(line_scores));
+
+	unsigned long long last_nodes = 0;
+	for (int depth = 1; depth <= max_depth; depth++) {
+		// the first iteration always completes
+		control.deadline = depth == 1 ? 0 : start + hard_limit;
+		control.stopped = false;
+		unsigned long long nodes_before = engine_stats.nodes;
+		double iteration_start = wall_time_ms();
+
+		int delta = depth >= ASPIRATION_MIN_DEPTH ? aspiration_delta : 0;
+		for (int line = 0; line < lines; line++) {
+			evaluated_move eval = aspiration_search(b, depth, turn, root_moves, num_moves, line, line_scores[line], delta);
+			if (!eval.best_move.piece) {
+				break;
+			}
+			line_scores[line] = eval.evaluation;
+			eval.evaluation = turn == WHITE ? eval.evaluation : -eval.evaluation;  // white's point of view, like minimax
+			if (line == 0) {
+				result = eval;
+				engine_pv = pv_table[0];
 			}
-			evaluated_move eval = minimax(b, depth - 1, WHITE, alpha, beta);
-			Entry e = {
-				.key = key,
-				.evaluation = eval.evaluation,
-				.depth = depth,
-				.best_move = m,
-				.alpha = alpha,
-				.beta = beta
-			};
-			insert_entry(&transposition_table, e);
 
-			unmake_move(b);
-			if (eval.evaluation < min_eval) {
-				min_eval = eval.evaluation;
-				_move.best_move = m;
+			// the move of the line goes to position 'line': the next line searches the moves after
+			// it, and the next iteration searches the lines in the same order, the best move first
+			for (int i = line; i < num_moves; i++) {
+				if (same_move(root_moves[i], eval.best_move)) {
+					Move best = root_moves[i];
+					memmove(&root_moves[line + 1], &root_moves[line], sizeof(Move) * (i - line));
+					root_moves[line] = best;
+					break;
+				}
 			}
-			beta = beta < eval.evaluation ? beta : eval.evaluation;
-			if (beta <= alpha) {
+
+			if (control.stopped) {
 				break;
 			}
+			if (limits.print_iterations) {
+				print_line(depth, lines > 1 ? line + 1 : 0, eval.evaluation, engine_stats.nodes - nodes_before, wall_time_ms() - start, &pv_table[0]);
+			}
 		}
-		_move.evaluation = min_eval;
-		return _move;
+
+		double now = wall_time_ms();
+		unsigned long long nodes = engine_stats.nodes - nodes_before;
+		if (control.stopped) {
+			break;
+		}
+		engine_stats.depth = depth;
+
+		// a mate within the depth searched is the shortest one, more depth won't change it
+		if (is_mate_score(result.evaluation) && MATE_SCORE - abs(result.evaluation) <= depth) {
+			break;
+		}
+
+		double branching_factor = last_nodes ? (double)nodes / last_nodes : DEFAULT_BRANCHING_FACTOR;
+		if (now - start + (now - iteration_start) * branching_factor > budget) {
+			break;
+		}
+		last_nodes = nodes;
+	}
+
+	control.deadline = 0;
+	control.stopped = false;
+	return result;
+}
+
+// root splitting: every thread takes the next root move nobody has searched, the best score is the
+// shared alpha, the transposition table is shared without locks (see Entry)
+typedef struct {
+	const char* fen;
+	int depth;
+	short turn;
+	int next_move;
+	evaluated_move best;
+	unsigned long long nodes;
+	pthread_mutex_t lock;
+} ParallelSearch;
+
+static void* search_worker(void* arg) {
+	ParallelSearch* p = arg;
+	short turn = p->turn;
+	board b;
+	load_fen(&b, (char*)p->fen);
+	update_attacks(&b);
+	engine_stats.nodes = 0;
+	push_position(get_zobrist_key(&b, &transposition_table, turn), 0);  // the root, for repetitions below it
+
+	MoveList* legal_moves = turn == WHITE ? b.white_legal_moves : b.black_legal_moves;
+	clear_move_list(b.white_attacks);
+	clear_move_list(b.black_attacks);
+	clear_move_list(legal_moves);
+	update_attacks_for_color(&b, !turn);
+	update_attacks_for_color(&b, turn);
+	filter_legal_moves(&b, turn);
+
+	int num_legal_moves = legal_moves->move_count;
+	quick_sort(legal_moves, 0, num_legal_moves - 1);
+
+	Move legal_moves_bk[num_legal_moves];
+	memcpy(legal_moves_bk, legal_moves->moves, sizeof(Move) * num_legal_moves);
+
+	uint64_t lookup_table_bk[97], *lookup_table_ptr;
+	lookup_table_ptr = turn == WHITE ? b.white_lookup_table : b.black_lookup_table;
+	memcpy(lookup_table_bk, lookup_table_ptr, sizeof(uint64_t) * 97);
+	uint64_t white_board_bk = b.white_board;
+	uint64_t black_board_bk = b.black_board;
+
+	while (true) {
+		pthread_mutex_lock(&p->lock);
+		int i = p->next_move++;
+		int bound = p->best.evaluation;
+		pthread_mutex_unlock(&p->lock);
+
+		if (i >= num_legal_moves) {
+			break;
+		}
+
+		memcpy(legal_moves->moves, legal_moves_bk, sizeof(Move) * num_legal_moves);
+		memcpy(lookup_table_ptr, lookup_table_bk, sizeof(uint64_t) * 97);
+		b.white_board = white_board_bk;
+		b.black_board = black_board_bk;
+		legal_moves->move_count = num_legal_moves;
+
+		Move m = legal_moves_bk[i];
+		if (make_move(m.src, m.dest, turn, &b, true, m.type) == INVALID_MOVE) {
+			continue;
+		}
+		int score = -negamax(&b, p->depth - 1, 1, !turn, -INFINITE_SCORE, -bound, PLACEHOLDER_MOVE).evaluation;
+		unmake_move(&b);
+
+		pthread_mutex_lock(&p->lock);
+		if (score > p->best.evaluation) {
+			p->best.evaluation = score;
+			p->best.best_move = m;
+		}
+		pthread_mutex_unlock(&p->lock);
+	}
+
+	pthread_mutex_lock(&p->lock);
+	p->nodes += engine_stats.nodes;
+	pthread_mutex_unlock(&p->lock);
+
+	free_board(&b);
+	return NULL;
+}
+
+evaluated_move minimax_parallel(const char* fen, int depth, short turn, int threads, unsigned long long* nodes) {
+	ParallelSearch p = {.fen = fen, .depth = depth, .turn = turn, .next_move = 0, .best = {-INFINITE_SCORE, PLACEHOLDER_MOVE}, .nodes = 0};
+	pthread_mutex_init(&p.lock, NULL);
+
+	pthread_t workers[threads];
+	for (int i = 0; i < threads; i++) {
+		pthread_create(&workers[i], NULL, search_worker, &p);
+	}
+	for (int i = 0; i < threads; i++) {
+		pthread_join(workers[i], NULL);
 	}
-}
\ No newline at end of file
+
+	pthread_mutex_destroy(&p.lock);
+	*nodes = p.nodes + 1;  // + the root
+	p.best.evaluation = turn == WHITE ? p.best.evaluation : -p.best.evaluation;
+	return p.best;
+}
@@ -1,5 +1,5 @@
 typedef struct {
-    double evaluation;
+    int evaluation;  // centipawns, see MATE_SCORE
     Move best_move;
 } evaluated_move;
 
@@ -18,6 +18,83 @@ typedef struct {
 } Move;
 */
 
-#define PLACEHOLDER_MOVE (Move) {{0, 0}, {0, 0}, 0, 0, 0, 0, 0, 0}
+typedef struct {
+    unsigned long long nodes;  // number of positions visited by minimax (quiescence included)
+    unsigned long long qnodes; // number of positions visited by the quiescence search
+    int depth;                 // depth of the last iteration iterative_deepening completed
+    unsigned long long cutoffs;            // beta cutoffs in negamax
+    unsigned long long first_move_cutoffs; // ... of which by the first move searched
+    unsigned long long root_searches;      // root searches of iterative_deepening, re-searches included
+    unsigned long long fail_highs;         // ... which failed high on the aspiration window
+    unsigned long long fail_lows;          // ... which failed low on the aspiration window
+} search_stats;
+
+extern _Thread_local search_stats engine_stats;
+
+/*
+    Limits of iterative_deepening (times in ms):
+    either a fixed time per move (move_time), or the clock (time_left, increment and moves_to_go,
+    0 moves to go -> estimated). max_depth 0 -> no depth limit.
+*/
+typedef struct {
+    double move_time;
+    double time_left;
+    double increment;
+    int moves_to_go;
+    int max_depth;
+    int aspiration_delta;  // initial half width of the aspiration window in centipawns, 0 -> ASPIRATION_DELTA, < 0 -> full window
+    int multi_pv;           // lines (best root moves) every iteration searches and prints, 0 -> 1
+    bool print_iterations;  // prints depth, evaluation, nodes, time and principal variation of every iteration
+} search_limits;
+
+#define MAX_SEARCH_DEPTH 64
+#define MAX_PLY 128  // killer moves are kept up to this distance from the root
+#define MAX_GAME_PLY 1024  // positions of the game kept for the detection of repetitions
+#define DELTA_MARGIN 200  // centipawns, see quiescence
+#define MAX_EXTENSIONS 16  // plies a line may be extended by in total (check extensions)
+#define IIR_MIN_DEPTH 4  // internal iterative reduction of nodes without a table move, see negamax
+#define PROBCUT_MIN_DEPTH 5
+#define PROBCUT_REDUCTION 4
+#define PROBCUT_MARGIN 50       // centipawns above beta, one step of the evaluation
+#define SINGULAR_MIN_DEPTH 6
+#define SINGULAR_DEPTH_MARGIN 3  // the table entry may be this much shallower than the node
+#define SINGULAR_MARGIN 4        // centipawns per ply below the table score the other moves have to stay
+#define NULL_MOVE_MIN_DEPTH 3
+#define NULL_MOVE_VERIFICATION_DEPTH 6
+#define RFP_DEPTH 3         // reverse futility pruning, see negamax
+#define RFP_MARGIN 100      // centipawns per ply
+#define RAZOR_DEPTH 2
+#define RAZOR_MARGIN 250
+#define FUTILITY_DEPTH 3
+#define FUTILITY_MARGIN 150
+#define LMR_MIN_DEPTH 3
+#define LMR_MIN_MOVES 3     // moves searched with the full depth before late move reductions start
+#define LMR_BASE 0.75       // reduction = LMR_BASE + log(depth) * log(move number) / LMR_DIVISOR
+#define LMR_DIVISOR 2.25
+#define NULL_WINDOW 1  // (alpha, alpha + 1) holds no score
+#define ASPIRATION_MIN_DEPTH 4
+#define ASPIRATION_DELTA 50       // centipawns, one step of the evaluation
+#define ASPIRATION_MAX_DELTA 800  // from here on the window is opened completely on the failing side
+#define DEFAULT_MOVES_TO_GO 30
+#define DEFAULT_BRANCHING_FACTOR 6.0
+
+#define PLACEHOLDER_MOVE (Move) {.src = {0, 0}, .dest = {0, 0}}
+
+// principal variation: the moves both sides are expected to play, from the root on
+typedef struct {
+    Move moves[MAX_PLY];
+    int length;
+} pv_line;
+
+extern _Thread_local pv_line engine_pv;  // of the last iteration iterative_deepening completed
 
-evaluated_move minimax(board *b, int depth, short maximizing_player, double alpha, double beta); 
\ No newline at end of file
+evaluated_move negamax(board *b, int depth, int ply, short turn, int alpha, int beta, Move excluded);
+evaluated_move minimax(board *b, int depth, short maximizing_player, int alpha, int beta);
+evaluated_move iterative_deepening(board *b, short turn, search_limits limits);
+evaluated_move minimax_parallel(const char *fen, int depth, short turn, int threads, unsigned long long* nodes);
+double wall_time_ms();
+void clear_move_ordering();
+void record_position(uint64_t key);
+void clear_position_history();
+bool is_repetition(board *b, uint64_t key, int ply);
+bool insufficient_material(board *b);
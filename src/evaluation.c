@@ -78,15 +78,15 @@ short num_isolated_pawns(board* board, short turn) {
 int get_weight_from_piece_type(uint8_t piece_type) {
 	switch (piece_type) {
 		case PAWN:
-			return 1;
+			return PAWN_VALUE;
 		case KNIGHT:
-			return 3;
+			return 3 * PAWN_VALUE;
 		case BISHOP:
-			return 3;
+			return 3 * PAWN_VALUE;
 		case ROOK:
-			return 5;
+			return 5 * PAWN_VALUE;
 		case QUEEN:
-			return 9;
+			return 9 * PAWN_VALUE;
 		default:
 			return 0;
 	}
@@ -98,9 +98,9 @@ bool static_in_check(short turn, board* board) {
 	return (king_position & opponent_attacks) != 0;
 }
 
-/* Calculates the evaluation of the Board */
-double get_evaluation_of_board(board* board) {
-	double eval = 0;
+/* Calculates the evaluation of the Board (mates and stalemates are left to the search) */
+int get_evaluation_of_board(board* board) {
+	int eval = 0;
 
 	// pieces captured by white
 	for (int i = 0; i < board->captured_pieces_count[WHITE]; i++) {
@@ -112,28 +112,23 @@ double get_evaluation_of_board(board* board) {
 		eval -= get_weight_from_piece_type(piece_type(board->captured_pieces[BLACK][i]));
 	}
 
-	eval -= static_in_check(WHITE, board);
-	eval += static_in_check(BLACK, board);
+	eval -= PAWN_VALUE * static_in_check(WHITE, board);
+	eval += PAWN_VALUE * static_in_check(BLACK, board);
 
-	eval -= 0.5 * (num_doubled_blocked_pawns(board, WHITE) - num_doubled_blocked_pawns(board, BLACK));
-	eval -= 0.5 * (num_isolated_pawns(board, WHITE) - num_isolated_pawns(board, BLACK));
-
-	if(board->white_legal_moves->move_count == 0) {
-		eval = INT_MIN;
-	} else if(board->black_legal_moves->move_count == 0) {
-		eval = INT_MAX;
-	}
+	eval -= PAWN_VALUE / 2 * (num_doubled_blocked_pawns(board, WHITE) - num_doubled_blocked_pawns(board, BLACK));
+	eval -= PAWN_VALUE / 2 * (num_isolated_pawns(board, WHITE) - num_isolated_pawns(board, BLACK));
 
 	return eval;
 }
 
 
-void display_evaluation(double eval) {
-    // Define bounds for eval
+void display_evaluation(int centipawns) {
+    // Define bounds for eval (in pawns)
     const double EVAL_MAX = 100.0;  // Adjust as needed for your application
     const double EVAL_MIN = -100.0;
 
     // Clamp eval to the defined range
+    double eval = (double)centipawns / PAWN_VALUE;
     if (eval > EVAL_MAX) {
         eval = EVAL_MAX;
     } else if (eval < EVAL_MIN) {
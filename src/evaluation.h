@@ -1,5 +1,21 @@
 #define FILEMASK_A 0b0000000100000001000000010000000100000001000000010000000100000001ULL
 
+/*
+    Scores are integer centipawns (PAWN_VALUE = 1 pawn), from white's point of view in the
+    evaluation and from the side to move's in the search.
+    Mate scores: the search scores a mate n plies away from the root MATE_SCORE - n, so shorter
+    mates score higher and every score beyond +-MATE_BOUND is a mate. The evaluation never
+    returns one, mates are found by the search from the moves it generates.
+    Draws score DRAW_SCORE. Every score fits into an int16_t (the transposition table),
+    INFINITE_SCORE is above all of them and only bounds the search window.
+*/
+#define PAWN_VALUE 100
+#define DRAW_SCORE 0
+#define MATE_SCORE 32000
+#define MATE_BOUND (MATE_SCORE - 1000)
+#define INFINITE_SCORE (MATE_SCORE + 1)
+
+int get_weight_from_piece_type(uint8_t piece_type);
 short num_attacked_pawns(board* board, short turn);
 short num_attacked_knights(board* board, short turn);
 short num_attacked_bishops(board* board, short turn);
@@ -7,5 +23,5 @@ short num_attacked_rooks(board* board, short turn);
 short num_attacked_queens(board* board, short turn);
 short num_doubled_blocked_pawns(board* board, short turn);
 short num_isolated_pawns(board* board, short turn);
-double get_evaluation_of_board(board* board);
-void display_evaluation(double eval);
\ No newline at end of file
+int get_evaluation_of_board(board* board);
+void display_evaluation(int centipawns);
\ No newline at end of file
@@ -18,11 +18,11 @@
 #include "evaluation.h"
 #include "transposition.h"
 #include "opening_book.h"
+#include "bench.h"
 
 #define STARTING_FEN "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq -"
 // #define STARTING_FEN "7r/8/4K1k1/1Q6/8/3N4/3q4/8 w - - 0 1"
-ZobristTable transposition_table;
-OpeningBook opening_book;
+#define LEVEL_MOVE_TIME 1000  // think time per move (ms) of every level of difficulty
 
 square read_square() {
 	char file;
@@ -119,7 +119,8 @@ void single_player(board *b, int level) {
 
 	short turn = WHITE;
 	update_attacks(b);
-	double evaluation = 0;
+	clear_position_history();
+	int evaluation = 0;
 
 	double time_taken = 0;
 	load_opening_book(&opening_book, "book.csv");
@@ -145,6 +146,7 @@ void single_player(board *b, int level) {
 		}
 
 		wprintf(L"%s's Turn: \n", turn == WHITE ? "Engine" : "Black");
+		uint64_t key = get_zobrist_key(b, &transposition_table, turn);  // recorded once the move is made
 
 		if (turn == BLACK) {
 			square src = read_square();
@@ -160,11 +162,13 @@ void single_player(board *b, int level) {
 			uint64_t lookup_table_backup[97];
 			memcpy(lookup_table_backup, turn == WHITE ? b->white_lookup_table : b->black_lookup_table, sizeof(lookup_table_backup));
 
+			search_limits limits = {.move_time = LEVEL_MOVE_TIME * level};
 			clock_t start = clock();
-			evaluated_move eval = minimax(b, 3 + level, turn, INT_MIN, INT_MAX);
+			evaluated_move eval = iterative_deepening(b, turn, limits);
 			clock_t end = clock();
 
 			time_taken = ((double)(end - start) * 1000.0) / CLOCKS_PER_SEC;
+			wprintf(L"Depth reached: %d\n", engine_stats.depth);
 			evaluation = eval.evaluation;
 
 			memcpy(turn == WHITE ? b->white_lookup_table : b->black_lookup_table, lookup_table_backup, sizeof(lookup_table_backup));
@@ -178,6 +182,7 @@ void single_player(board *b, int level) {
 			}
 		}
 
+		record_position(key);  // the engine looks for repetitions of the positions played
 		update_attacks(b);
 		turn = !turn;
 	}
@@ -236,8 +241,51 @@ void reset_input_mode() {
 	tcsetattr(STDIN_FILENO, TCSANOW, &tattr);
 }
 
-int main() {
+// searches the position for 'move_time' ms and prints every iteration, 'multi_pv' lines each
+void go(double move_time, char *fen, int multi_pv) {
+	board b;
+	load_fen(&b, fen);
+	update_attacks(&b);
+	init_zobrist(&transposition_table);
+
+	char *side = strchr(fen, ' ');
+	short turn = side && side[1] == 'b' ? BLACK : WHITE;
+
+	search_limits limits = {.move_time = move_time, .multi_pv = multi_pv, .print_iterations = true};
+	evaluated_move eval = iterative_deepening(&b, turn, limits);
+	wprintf(L"root searches %llu (aspiration fail high %llu, fail low %llu)\n", engine_stats.root_searches, engine_stats.fail_highs, engine_stats.fail_lows);
+	wprintf(L"bestmove %c%d%c%d\n", eval.best_move.src.file + 'a' - 1, eval.best_move.src.rank, eval.best_move.dest.file + 'a' - 1, eval.best_move.dest.rank);
+	free_board(&b);
+}
+
+/*
+    Usage:
+    ./chess [--hash MB]                     -> interactive menu
+    ./chess [--hash MB] bench [depth]       -> fixed depth search of the bench positions (see bench.c)
+    ./chess [--hash MB] go <ms> [fen] [n]   -> iterative deepening search of the position for <ms> milliseconds,
+                                               n > 1 prints the best n moves with their lines (MultiPV)
+
+    --hash sets the size of the transposition table (DEFAULT_HASH_MB if not given).
+*/
+int main(int argc, char *argv[]) {
 	setlocale(LC_ALL, "");
+	if (argc > 2 && strcmp(argv[1], "--hash") == 0) {
+		if (!resize_table(&transposition_table, strtoull(argv[2], NULL, 10))) {
+			return 1;
+		}
+		argc -= 2;
+		argv += 2;
+	}
+
+	if (argc > 1 && strcmp(argv[1], "bench") == 0) {
+		bench(argc > 2 ? atoi(argv[2]) : BENCH_DEPTH);
+		return 0;
+	}
+	if (argc > 2 && strcmp(argv[1], "go") == 0) {
+		go(atof(argv[2]), argc > 3 ? argv[3] : STARTING_FEN, argc > 4 ? atoi(argv[4]) : 1);
+		return 0;
+	}
+
 	board b;
 	char mode;
 	set_input_mode();
@@ -17,6 +17,7 @@ typedef struct {
 
 	uint8_t castle_rights;
 	uint8_t type;
+	uint8_t halfmove_clock;  // of the position before the move
 
 	bool is_check;
 	unsigned int score;
@@ -48,6 +49,7 @@ typedef struct {
 #define CHECK_MOVE 5
 #define CHECKMATE_MOVE 6
 #define STALEMATE_MOVE 7
+#define PASS_MOVE 8  // null move: the side to move passes (only used by the search)
 #define INVALID_MOVE -1
 
 #endif
\ No newline at end of file
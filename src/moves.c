@@ -953,7 +953,8 @@ short make_move(square src, square dest, short turn, board *b, bool is_engine, u
 	    .en_passant_square = b->en_passant_square,
 	    .promoted_piece = 0,
 	    .castle_rights = b->castle_rights,
-	    .type = INVALID_MOVE};
+	    .type = INVALID_MOVE,
+	    .halfmove_clock = b->halfmove_clock};
 
 	// check if the source square is empty
 	if (piece == EMPTY_SQUARE) {
@@ -1080,6 +1081,13 @@ short make_move(square src, square dest, short turn, board *b, bool is_engine, u
 		b->en_passant_square = 0ULL;
 	}
 
+	// captures and pawn moves are irreversible, they restart the count of the fifty move rule
+	if (piece_type(piece) == PAWN || m.captured_piece != EMPTY_SQUARE) {
+		b->halfmove_clock = 0;
+	} else if (b->halfmove_clock < UINT8_MAX) {
+		b->halfmove_clock++;
+	}
+
 	// update castle rights
 
 	// do not check for castle flags if they are already set to invalid
@@ -1174,6 +1182,11 @@ short unmake_move(board *b) {
 	if (last_move.type == INVALID_MOVE) {
 		return INVALID_MOVE;
 	}
+	b->halfmove_clock = last_move.halfmove_clock;
+	if (last_move.type == PASS_MOVE) {
+		b->en_passant_square = last_move.en_passant_square;
+		return true;
+	}
 	switch (last_move.type) {
 		case NORMAL_MOVE:
 			/*
@@ -1339,6 +1352,20 @@ short unmake_move(board *b) {
 	return true;
 }
 
+/*
+    Null move: the side to move passes, no piece moves. The en passant square is cleared (the
+    pawn can't be taken en passant any more), everything else stays. Like make_move this doesn't
+    store the side to move, the caller continues with the other color, which is what flips the
+    side to move in the zobrist key (get_zobrist_key takes the turn). The null move goes onto the
+    move stack, so it is taken back with unmake_move.
+    The halfmove clock is kept, the search stops its repetition scan at the null move instead.
+*/
+void make_null_move(board *b) {
+	Move m = {.piece = EMPTY_SQUARE, .en_passant_square = b->en_passant_square, .castle_rights = b->castle_rights, .type = PASS_MOVE, .halfmove_clock = b->halfmove_clock};
+	push(b->moves, m);
+	b->en_passant_square = 0ULL;
+}
+
 void update_type_board(board *b, short turn) {
 	if (turn == WHITE) {
 		b->white_board = white_board(b);
@@ -1696,7 +1723,7 @@ bool in_check_alt(short color, board *b) {
 			return true;
 		}
 
-		if (piece_type(piece) == KING && j == king_file - 1 && i == king_rank - 1) {
+		if (piece_type(piece) == KING && i == king_file - 1 && j == king_rank - 1) {
 			return true;
 		}
 		break;
@@ -1748,6 +1775,142 @@ bool in_check_alt(short color, board *b) {
 	return false;
 }
 
+/*
+    Attack maps computed straight from the piece bitboards:
+    Unlike the lookup tables these don't depend on the state of the move lists, so they can
+    be queried at any time (e.g. right after make_move). The occupancy is passed in explicitly
+    so that callers can remove pieces from it and look "through" them (x-rays).
+*/
+uint64_t pieces_of_type(board *b, short color, uint8_t type) {
+	pieces *p = color == WHITE ? b->white : b->black;
+	uint64_t bb = 0ULL;
+
+	if (type == KING) {
+		return p->king;
+	}
+
+	uint64_t **ptr = get_pointer_to_piece_type(color, type, b);
+	short *counter = get_pointer_to_piece_counter(b, type | (color == WHITE ? 0 : 8));
+	if (!ptr || !counter) {
+		return 0ULL;
+	}
+
+	for (int i = 0; i < *counter; i++) {
+		bb |= (*ptr)[i];
+	}
+	return bb;
+}
+
+uint64_t slider_attacks(uint64_t position, uint64_t occupancy, bool diagonal) {
+	uint64_t (*directions[4])(uint64_t) = {move_north, move_south, move_east, move_west};
+	uint64_t (*diagonals[4])(uint64_t) = {move_north_east, move_north_west, move_south_east, move_south_west};
+	uint64_t attacks = 0ULL;
+
+	for (int i = 0; i < 4; i++) {
+		uint64_t ray = position;
+		while (ray) {
+			ray = diagonal ? diagonals[i](ray) : directions[i](ray);
+			attacks |= ray;
+			if (ray & occupancy) {
+				break;
+			}
+		}
+	}
+	return attacks;
+}
+
+uint64_t knight_attacks_from(uint64_t position) {
+	return move_north(move_north_east(position)) | move_north(move_north_west(position)) |
+	       move_east(move_north_east(position)) | move_east(move_south_east(position)) |
+	       move_south(move_south_east(position)) | move_south(move_south_west(position)) |
+	       move_west(move_north_west(position)) | move_west(move_south_west(position));
+}
+
+uint64_t king_attacks_from(uint64_t position) {
+	return move_north(position) | move_south(position) | move_east(position) | move_west(position) |
+	       move_north_east(position) | move_north_west(position) | move_south_east(position) | move_south_west(position);
+}
+
+// returns bitboard of all pieces of 'color' (restricted to 'occupancy') that attack the target square
+uint64_t attackers_to(uint64_t target, short color, uint64_t occupancy, board *b) {
+	uint64_t attackers = 0ULL;
+	uint64_t pawn_squares = color == WHITE ? (move_south_east(target) | move_south_west(target))
+	                                       : (move_north_east(target) | move_north_west(target));
+	uint64_t queens = pieces_of_type(b, color, QUEEN);
+
+	attackers |= pawn_squares & pieces_of_type(b, color, PAWN);
+	attackers |= knight_attacks_from(target) & pieces_of_type(b, color, KNIGHT);
+	attackers |= king_attacks_from(target) & pieces_of_type(b, color, KING);
+	attackers |= slider_attacks(target, occupancy, true) & (pieces_of_type(b, color, BISHOP) | queens);
+	attackers |= slider_attacks(target, occupancy, false) & (pieces_of_type(b, color, ROOK) | queens);
+
+	return attackers & occupancy;
+}
+
+// returns bitboard of opponent pieces giving check to the king of 'color'
+uint64_t checkers(short color, board *b) {
+	uint64_t king_position = color == WHITE ? b->white->king : b->black->king;
+	return attackers_to(king_position, !color, b->white_board | b->black_board, b);
+}
+
+/*
+    Static exchange evaluation (SEE):
+    The material (in centipawns) the moving side wins or loses if both sides keep capturing on the
+    destination square, always with their least valuable attacker, and each side may stop as soon
+    as capturing further would lose material. The attackers are recomputed from the occupancy
+    after every capture, so sliders lined up behind a capturing piece join in (x-rays).
+*/
+int static_exchange_evaluation(Move m, short turn, board *b) {
+	int gain[32], d = 0;
+	uint64_t target = get_bitboard(m.dest.file, m.dest.rank);
+	uint64_t occupancy = (b->white_board | b->black_board) & ~get_bitboard(m.src.file, m.src.rank);
+
+	uint8_t attacker_type = piece_type(m.piece);
+	gain[0] = m.captured_piece ? get_weight_from_piece_type(piece_type(m.captured_piece)) : 0;
+	if (m.type == EN_PASSANT_MOVE) {
+		occupancy &= ~get_bitboard(m.dest.file, m.src.rank);
+	}
+	if (m.promoted_piece) {
+		attacker_type = piece_type_from_promotion_flag(m.type);
+		gain[0] += get_weight_from_piece_type(attacker_type) - get_weight_from_piece_type(PAWN);
+	}
+
+	short side = !turn;
+	while (d < 31) {
+		uint64_t attackers = attackers_to(target, side, occupancy, b);
+		if (!attackers) {
+			break;
+		}
+
+		// least valuable attacker
+		uint8_t type;
+		uint64_t attacker = 0ULL;
+		for (type = PAWN; type <= KING && !attacker; type++) {
+			attacker = pieces_of_type(b, side, type) & attackers;
+		}
+		type--;
+		attacker &= -attacker;
+
+		// the king can only capture if the square isn't defended any more
+		if (type == KING && attackers_to(target, !side, occupancy & ~attacker, b)) {
+			break;
+		}
+
+		d++;
+		gain[d] = (attacker_type == KING ? SEE_KING_VALUE : get_weight_from_piece_type(attacker_type)) - gain[d - 1];
+		occupancy &= ~attacker;
+		attacker_type = type;
+		side = !side;
+	}
+
+	// a side only continues the exchange if that doesn't make things worse for it
+	while (d > 0) {
+		gain[d - 1] = -(-gain[d - 1] > gain[d] ? -gain[d - 1] : gain[d]);
+		d--;
+	}
+	return gain[0];
+}
+
 void print_move(Move m) {
 	wprintf(L"(%c, %d) -> (%c, %d), piece : %d, captured piece : %d, promoted piece : %d, castle rights : %d, type : %d\n", m.src.file + 'A' - 1, m.src.rank, m.dest.file + 'A' - 1, m.dest.rank, m.piece, m.captured_piece, m.promoted_piece, m.castle_rights, m.type);
 }
@@ -1786,9 +1949,10 @@ unsigned int get_score(Move m, board *b) {
 
 	unsigned int score = 0;
 
-	// 1. capture move advantage
-	if (m.type == CAPTURE_MOVE) {
-		score += 10;
+	// 1. capture move advantage: most valuable victim first, of those the least valuable attacker
+	//    first (MVV-LVA), one step in the victim outweighs all the other bonuses together
+	if (m.captured_piece != 0) {
+		score += 100 * (8 * piece_type(m.captured_piece) - piece_type(m.piece));
 	}
 
 	// 2. check move advantage
@@ -1806,17 +1970,12 @@ unsigned int get_score(Move m, board *b) {
 		score += 10;
 	}
 
-	// 5. promotion + check move advantage
-	if (m.captured_piece != 0) {
-		score += 15;
-	}
-
-	// 6. castling move advantage
+	// 5. castling move advantage
 	if (m.type == CASTLE_MOVE) {
 		score += 10;
 	}
 
-	// 7. move that encourages knights and bishops to move to the center of the board
+	// 6. move that encourages knights and bishops to move to the center of the board
 	if (piece_type(m.piece) == KNIGHT || piece_type(m.piece) == BISHOP) {
 		if (m.dest.file == D || m.dest.file == E || m.dest.file == D || m.dest.file == F) {
 			if (m.dest.rank == 4 || m.dest.rank == 5 || m.dest.rank == 4 || m.dest.rank == 5) {
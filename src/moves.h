@@ -6,6 +6,7 @@ uint64_t generate_pawn_attacks(uint8_t pawn_id, uint64_t pawn_position, board *b
 uint64_t generate_bishop_attacks(uint8_t bishop_id, uint64_t bishop_position, board *b);
 short make_move(square src, square dest, short turn, board *b, bool is_engine, uint8_t promotion_move_flag);
 short unmake_move(board *b);
+void make_null_move(board *b);
 void update_attacks(board *b);
 void update_attacks_for_color(board *b, short color);
 void update_type_board(board *b, short turn);
@@ -18,5 +19,14 @@ uint8_t get_id_of_promoted_piece(uint8_t piece_type, short color, short piece_nu
 bool in_check(short color, board *b);
 bool in_check_alt(short color, board *b);
 uint64_t validate_castle(uint64_t king_position, short color, board *b);
+uint64_t pieces_of_type(board *b, short color, uint8_t type);
+uint64_t slider_attacks(uint64_t position, uint64_t occupancy, bool diagonal);
+uint64_t knight_attacks_from(uint64_t position);
+uint64_t king_attacks_from(uint64_t position);
+uint64_t attackers_to(uint64_t target, short color, uint64_t occupancy, board *b);
+uint64_t checkers(short color, board *b);
+
+#define SEE_KING_VALUE 10000  // centipawns, more than any exchange can win
+int static_exchange_evaluation(Move m, short turn, board *b);
 
 uint64_t generate_king_attacks(uint8_t king_id, uint64_t king_position, board *b);
\ No newline at end of file
@@ -7,7 +7,13 @@
 
 #include "opening_book.h"
 
+OpeningBook opening_book;
+
 void init_opening_book(OpeningBook* book) {
+	// the book holds a few ten thousand positions, it doesn't need a table of the search's size
+	if (!book->OpeningBookTable.table && !resize_table(&book->OpeningBookTable, BOOK_HASH_MB)) {
+		exit(1);
+	}
 	init_zobrist(&book->OpeningBookTable);
 	book->num_entries = 0;
 }
@@ -78,12 +84,8 @@ unsigned long load_opening_book(OpeningBook* book, char* filename) {
 		load_fen(&b, fen);
         turn = t=='w' ? WHITE : BLACK;
 
-		Entry e;
-		e.key = get_zobrist_key(&b, &book->OpeningBookTable, turn);
-		e.best_move = move_from_string(move, turn);
-		e.is_book_move = true;
-
-		insert_entry(&book->OpeningBookTable, e);
+		unsigned long long key = get_zobrist_key(&b, &book->OpeningBookTable, turn);
+		insert_entry(&book->OpeningBookTable, key, move_from_string(move, turn), 0, 0, BOUND_EXACT);
 		book->num_entries++;
 	}
 
@@ -92,11 +94,14 @@ unsigned long load_opening_book(OpeningBook* book, char* filename) {
 }
 
 Move get_book_move(OpeningBook* book, board* b, short turn) {
+	if (book->num_entries == 0) {
+		return (Move){0};
+	}
 	unsigned long long key = get_zobrist_key(b, &book->OpeningBookTable, turn);
 
-	Entry* e = get_entry(&book->OpeningBookTable, key);
-	if (e && e->is_book_move) {
-		return e->best_move;
+	Entry e;
+	if (get_entry(&book->OpeningBookTable, key, &e)) {
+		return entry_move(&e, turn);
 	}
 	return (Move){0};
 }
\ No newline at end of file
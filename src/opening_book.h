@@ -4,6 +4,8 @@
 #include "move_types.h"
 #include "transposition.h"
 
+#define BOOK_HASH_MB 2
+
 typedef struct {
     ZobristTable OpeningBookTable;    
     int num_entries;
@@ -3,57 +3,19 @@
 #include <stdlib.h>
 #include <string.h>
 #include <wchar.h>
-#include <locale.h>
-#include <time.h>
-#include <assert.h>
+#include <pthread.h>
 
 #include "chessboard.h"
 #include "move_types.h"
 #include "moves.h"
 #include "move_array.h"
 #include "move_stack.h"
+#include "perft.h"
 
-#define RED_TEXT "\033[0;31m"
-#define GREEN_TEXT "\033[0;32m"
-#define RESET "\033[0m"
-
-void print_squares_from_bb(uint64_t bb) {
-	for (int i = 0; i < 64; i++) {
-		if (bb & (1ULL << i)) {
-			int file = i % 8;
-			int rank = i / 8;
-			wprintf(L"%c%d ", file + 'a', rank + 1);
-		}
-	}
-	wprintf(L"\n");
-}
-#define STARTING_FEN "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1"
-#define TURN WHITE
-// #define MAX_DEPTH 6
-
-typedef struct {
-	char* fen;
-	int depth;
-	unsigned long long nodes;
-	unsigned long long expected_nodes;
-} PerftTest;
-
-#define TEST_1 "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1 "
-#define TEST_2 "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - "
-#define TEST_3 "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - "
-#define TEST_4 "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1"
-#define TEST_5 "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8 "
-#define TEST_6 "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10 "
-
-const PerftTest perft_test_suite[] = {
-    (PerftTest){TEST_1, 6, 0, 119060324},  // {20, 400, 8902, 197281, 4865609, 119060324}
-    (PerftTest){TEST_2, 5, 0, 193690690},  // {48, 2039, 97862, 4085603, 193690690}
-    (PerftTest){TEST_3, 7, 0, 178633661},   // {14, 191, 2812, 43238, 674624, 11030083}
-    (PerftTest){TEST_4, 5, 0, 15833292},   // {6, 264, 9467, 422333, 15833292}
-    (PerftTest){TEST_5, 5, 0, 89941194},   // {44, 1486, 62379, 2103487, 89941194}
-    (PerftTest){TEST_6, 5, 0, 164075551}   // {46, 2079, 89890, 3894594, 164075551}
-};
-
+/*
+    perfit() counts the leaf nodes of the legal move tree, at max_depth the node count of
+    every root move is printed as well (pass 0 to keep it quiet).
+*/
 unsigned long long perfit(int depth, short turn, board* b, const int max_depth) {
 	if (depth == 0) {
 		return 1ULL;
@@ -150,75 +112,193 @@ unsigned long long perfit(int depth, short turn, board* b, const int max_depth)
 	return nodes;
 }
 
-void single_perft_test(const char* fen, int depth, int turn) {
-	board b;
-	load_fen(&b, (char*)fen);
-	clear_move_list(b.white_attacks);
-	clear_move_list(b.black_attacks);
+// generates the legal moves of 'turn' into its legal move list, same as every perft node does
+void generate_legal_moves(short turn, board* b) {
+	MoveList* pseudo_legal_moves = turn == WHITE ? b->white_attacks : b->black_attacks;
+	MoveList* legal_moves = turn == WHITE ? b->white_legal_moves : b->black_legal_moves;
 
-	if (turn == WHITE) {
-		update_attacks_for_color(&b, BLACK);
-		update_attacks_for_color(&b, WHITE);
+	clear_move_list(pseudo_legal_moves);
+	clear_move_list(legal_moves);
 
-		filter_legal_moves(&b, WHITE);
-	} else {
-		update_attacks_for_color(&b, WHITE);
-		update_attacks_for_color(&b, BLACK);
+	b->black_attacks->move_count = 0;
+	update_attacks_for_color(b, !turn);
+
+	b->white_attacks->move_count = 0;
+	update_attacks_for_color(b, turn);
+	filter_legal_moves(b, turn);
+}
 
-		filter_legal_moves(&b, BLACK);
+// classifies the move which was just made by 'turn' (it is on top of the move stack)
+static void count_leaf(Move m, short turn, board* b, PerftStats* stats) {
+	stats->nodes++;
+
+	if (m.captured_piece != EMPTY_SQUARE) {
+		stats->captures++;
+	}
+	if (m.type == EN_PASSANT_MOVE) {
+		stats->en_passants++;
+	}
+	if (m.type == CASTLE_MOVE) {
+		stats->castles++;
+	}
+	if (m.promoted_piece != 0) {
+		stats->promotions++;
 	}
 
-	wprintf(L"White board: ");
-	print_squares_from_bb(b.white_board);
+	uint64_t checking_pieces = checkers(!turn, b);
+	if (!checking_pieces) {
+		return;
+	}
+	stats->checks++;
 
-	wprintf(L"\nBlack board: ");
-	print_squares_from_bb(b.black_board);
+	// squares of the pieces that moved, any other checker was uncovered by the move
+	// (as in the published tables, double checks are not counted as discovered checks)
+	uint64_t moved = get_bitboard(m.dest.file, m.dest.rank);
+	if (m.type == CASTLE_MOVE) {
+		moved |= get_bitboard(m.dest.file == G ? F : D, m.dest.rank);
+	}
+	if (__builtin_popcountll(checking_pieces) > 1) {
+		stats->double_checks++;
+	} else if (checking_pieces & ~moved) {
+		stats->discovered_checks++;
+	}
 
-	wprintf(L"\nblack king attacks: ");
-	print_squares_from_bb(generate_king_attacks(BLACK_KING, b.black->king, &b));
+	// the lookup table of 'turn' is restored by the caller before its next move
+	generate_legal_moves(!turn, b);
+	if ((turn == WHITE ? b->black_legal_moves : b->white_legal_moves)->move_count == 0) {
+		stats->checkmates++;
+	}
+}
+
+void perfit_stats(int depth, short turn, board* b, PerftStats* stats) {
+	if (depth == 0) {
+		stats->nodes++;
+		return;
+	}
 
-	wprintf(L"\n========================================\n");
+	generate_legal_moves(turn, b);
 
-	clock_t start = clock();
-	unsigned long long nodes = perfit(depth, turn, &b, depth);
-	clock_t end = clock();
+	MoveList* legal_moves = turn == WHITE ? b->white_legal_moves : b->black_legal_moves;
+	int move_count = legal_moves->move_count;
+	Move legal_moves_bk[move_count];
+	memcpy(legal_moves_bk, legal_moves->moves, sizeof(Move) * move_count);
 
-	wprintf(L"Nodes: %llu\n", nodes);
-	wprintf(L"time_ms = %.2lf\n", ((double)(end - start) * 1000.0) / CLOCKS_PER_SEC);
+	uint64_t lookup_table_bk[97], *lookup_table_ptr;
+	lookup_table_ptr = turn == WHITE ? b->white_lookup_table : b->black_lookup_table;
+	memcpy(lookup_table_bk, lookup_table_ptr, sizeof(uint64_t) * 97);
 
-	return;
-}
+	uint64_t white_board_bk = b->white_board;
+	uint64_t black_board_bk = b->black_board;
 
-void perfit_test() {
-	int num_tests = sizeof(perft_test_suite) / sizeof(PerftTest);
-	for (int i = 0; i < num_tests; i++) {
-		board b;
-		init_board(&b);
-		load_fen(&b, perft_test_suite[i].fen);
-		clear_move_list(b.white_attacks);
-		clear_move_list(b.black_attacks);
-
-		update_attacks_for_color(&b, BLACK);
-		update_attacks_for_color(&b, WHITE);
-
-		wprintf(L"Running test %d: %s\n", i + 1, perft_test_suite[i].fen);
-		clock_t start = clock();
-		unsigned long long nodes = perfit(perft_test_suite[i].depth, TURN, &b, perft_test_suite[i].depth);
-		clock_t end = clock();
-		double time = ((double)(end - start) * 1000.0) / CLOCKS_PER_SEC;
-		wprintf(L"Nodes: %llu, time_ms = %.2lf\n", nodes, time);
-
-		if (nodes == perft_test_suite[i].expected_nodes) {
-			wprintf(L"Test %d: " GREEN_TEXT "PASSED\n" RESET, i + 1);
+	for (int i = 0; i < move_count; i++) {
+		memcpy(legal_moves->moves, legal_moves_bk, sizeof(Move) * move_count);
+		memcpy(lookup_table_ptr, lookup_table_bk, sizeof(uint64_t) * 97);
+		b->white_board = white_board_bk;
+		b->black_board = black_board_bk;
+		legal_moves->move_count = move_count;
+
+		Move m = legal_moves_bk[i];
+		if (!m.piece) {
+			continue;
+		}
+
+		int status = make_move(m.src, m.dest, turn, b, true, m.type);
+		if (status == INVALID_MOVE) {
+			wprintf(L"%c%d -> %c%d: INVALID MOVE\n", m.src.file + 'a' - 1, m.src.rank, m.dest.file + 'a' - 1, m.dest.rank);
+			print_board(b, turn, 1);
+			exit(1);
+		}
+
+		if (depth == 1) {
+			count_leaf(m, turn, b, stats);
 		} else {
-			wprintf(L"Test %d: " RED_TEXT "FAILED\n" RESET, i + 1);
-			wprintf(L"Expected: %llu, Got: %llu\n", perft_test_suite[i].expected_nodes, nodes);
+			perfit_stats(depth - 1, !turn, b, stats);
 		}
+		unmake_move(b);
 	}
 }
 
-int main() {
-	setlocale(LC_ALL, "");
-	perfit_test();
-	return 0;
+/*
+    Parallel perft:
+    The root moves are split between the threads. Every thread has its own board (loaded from the
+    fen, the board state can't be shared) and takes the next root move that nobody has counted
+    yet, so a thread which got small subtrees simply counts more of them.
+*/
+typedef struct {
+	const char* fen;
+	int depth;
+	short turn;
+	int next_move;
+	unsigned long long nodes;
+	pthread_mutex_t lock;
+} ParallelPerft;
+
+static int claim_root_move(ParallelPerft* p) {
+	pthread_mutex_lock(&p->lock);
+	int index = p->next_move++;
+	pthread_mutex_unlock(&p->lock);
+	return index;
+}
+
+static void* perfit_worker(void* arg) {
+	ParallelPerft* p = arg;
+	board b;
+	load_fen(&b, (char*)p->fen);
+	update_attacks(&b);
+	generate_legal_moves(p->turn, &b);
+
+	MoveList* legal_moves = p->turn == WHITE ? b.white_legal_moves : b.black_legal_moves;
+	int move_count = legal_moves->move_count;
+	Move legal_moves_bk[move_count];
+	memcpy(legal_moves_bk, legal_moves->moves, sizeof(Move) * move_count);
+
+	uint64_t lookup_table_bk[97], *lookup_table_ptr;
+	lookup_table_ptr = p->turn == WHITE ? b.white_lookup_table : b.black_lookup_table;
+	memcpy(lookup_table_bk, lookup_table_ptr, sizeof(uint64_t) * 97);
+
+	uint64_t white_board_bk = b.white_board;
+	uint64_t black_board_bk = b.black_board;
+	unsigned long long nodes = 0;
+
+	for (int i = claim_root_move(p); i < move_count; i = claim_root_move(p)) {
+		memcpy(legal_moves->moves, legal_moves_bk, sizeof(Move) * move_count);
+		memcpy(lookup_table_ptr, lookup_table_bk, sizeof(uint64_t) * 97);
+		b.white_board = white_board_bk;
+		b.black_board = black_board_bk;
+		legal_moves->move_count = move_count;
+
+		Move m = legal_moves_bk[i];
+		if (!m.piece || make_move(m.src, m.dest, p->turn, &b, true, m.type) == INVALID_MOVE) {
+			continue;
+		}
+		nodes += perfit(p->depth - 1, !p->turn, &b, 0);
+		unmake_move(&b);
+	}
+
+	pthread_mutex_lock(&p->lock);
+	p->nodes += nodes;
+	pthread_mutex_unlock(&p->lock);
+
+	free_board(&b);
+	return NULL;
+}
+
+unsigned long long perfit_parallel(int depth, short turn, const char* fen, int threads) {
+	if (depth == 0) {
+		return 1ULL;
+	}
+
+	ParallelPerft p = {.fen = fen, .depth = depth, .turn = turn, .next_move = 0, .nodes = 0};
+	pthread_mutex_init(&p.lock, NULL);
+
+	pthread_t workers[threads];
+	for (int i = 0; i < threads; i++) {
+		pthread_create(&workers[i], NULL, perfit_worker, &p);
+	}
+	for (int i = 0; i < threads; i++) {
+		pthread_join(workers[i], NULL);
+	}
+
+	pthread_mutex_destroy(&p.lock);
+	return p.nodes;
 }
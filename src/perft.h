@@ -0,0 +1,33 @@
+#ifndef PERFT_H
+#define PERFT_H
+
+#include "chessboard.h"
+
+/*
+    Extended perft:
+    Besides the node total, every move made at the last ply is classified the same way as the
+    published perft tables (chessprogramming.org/Perft_Results) do it, so a mismatch immediately
+    tells which kind of move (captures, en passant, castles, promotions, checks or mates) is
+    being generated wrongly.
+
+    Checks are found from the piece bitboards of the moved side (see attackers_to), only the
+    positions which are actually in check are expanded once more to find the mates, so the
+    overhead over a plain perft stays small.
+*/
+typedef struct {
+	unsigned long long nodes;
+	unsigned long long captures;
+	unsigned long long en_passants;
+	unsigned long long castles;
+	unsigned long long promotions;
+	unsigned long long checks;
+	unsigned long long discovered_checks;
+	unsigned long long double_checks;
+	unsigned long long checkmates;
+} PerftStats;
+
+unsigned long long perfit(int depth, short turn, board* b, const int max_depth);
+void perfit_stats(int depth, short turn, board* b, PerftStats* stats);
+void generate_legal_moves(short turn, board* b);
+unsigned long long perfit_parallel(int depth, short turn, const char* fen, int threads);
+#endif
@@ -0,0 +1,321 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <wchar.h>
+#include <locale.h>
+#include <time.h>
+#include <math.h>
+
+#include "chessboard.h"
+#include "move_types.h"
+#include "moves.h"
+#include "move_array.h"
+#include "evaluation.h"
+#include "engine.h"
+#include "transposition.h"
+#include "perft.h"
+#include "bench.h"
+
+/*
+    Performance regression gate:
+    Every bench position is run through perfit (move generation) and minimax (search) a number
+    of times. The median time and its median absolute deviation (MAD) over the runs are recorded
+    together with the node counts into the baseline file, later runs are compared against it.
+    One sample of a workload repeats it until it takes at least MIN_SAMPLE_MS, so short workloads
+    aren't lost in the timer resolution; the repeat count is stored in the baseline and reused.
+
+    A workload counts as slower only if its median is worse than the baseline by more than the
+    tolerance AND by more than 'mad factor' times the combined MADs, so a noisy machine doesn't
+    make the gate flap. The gate also fails when a perft node count changes (that is a move
+    generation bug), a changed search node count only means the search changed: the speed is then
+    compared in nodes/second and the baseline should be recorded again.
+
+    Usage:
+    ./regression [--update] [--runs N] [--tolerance PERCENT] [--mad-factor K] [--baseline FILE]
+
+    Exit status: 0 -> no regression, 1 -> regression, 2 -> baseline missing or invalid arguments
+*/
+
+#define BASELINE_FILE "regression_baseline.csv"
+#define PERFT_DEPTH 3
+#define SEARCH_DEPTH BENCH_DEPTH
+#define MIN_SAMPLE_MS 250.0
+#define DEFAULT_RUNS 7
+#define MAX_RUNS 64
+#define DEFAULT_TOLERANCE 10.0
+#define DEFAULT_MAD_FACTOR 3.0
+#define MAX_RECORDS 128
+
+typedef enum { PERFT, SEARCH } WorkloadKind;
+
+const char* kind_names[] = {"perft", "search"};
+
+typedef struct {
+	WorkloadKind kind;
+	int position;
+	int depth;
+	int repeats;  // runs of the workload per sample
+	unsigned long long nodes;
+	double median_ms;
+	double mad_ms;
+	double nps;
+} Record;
+
+typedef struct {
+	bool update;
+	int runs;
+	double tolerance;
+	double mad_factor;
+	const char* baseline;
+} Options;
+
+static int compare_doubles(const void* a, const void* b) {
+	double x = *(const double*)a, y = *(const double*)b;
+	return (x > y) - (x < y);
+}
+
+static double median(double* values, int n) {
+	double sorted[MAX_RUNS];
+	memcpy(sorted, values, sizeof(double) * n);
+	qsort(sorted, n, sizeof(double), compare_doubles);
+	return n % 2 ? sorted[n / 2] : (sorted[n / 2 - 1] + sorted[n / 2]) / 2.0;
+}
+
+static double median_absolute_deviation(double* values, int n, double m) {
+	double deviations[MAX_RUNS];
+	for (int i = 0; i < n; i++) {
+		deviations[i] = fabs(values[i] - m);
+	}
+	return median(deviations, n);
+}
+
+// runs one workload 'repeats' times, returns the node count of one run and stores the time all of them took
+static unsigned long long run_workload(WorkloadKind kind, int position, int depth, int repeats, double* time_ms) {
+	unsigned long long nodes = 0;
+	*time_ms = 0;
+
+	for (int i = 0; i < repeats; i++) {
+		board b;
+		load_fen(&b, bench_positions[position].fen);
+		update_attacks(&b);
+
+		clock_t start, end;
+		if (kind == PERFT) {
+			start = clock();
+			nodes = perfit(depth, bench_positions[position].turn, &b, 0);
+			end = clock();
+		} else {
+			clear_table(&transposition_table);
+			clear_move_ordering();
+			engine_stats = (search_stats){0};
+			start = clock();
+			minimax(&b, depth, bench_positions[position].turn, -INFINITE_SCORE, INFINITE_SCORE);
+			end = clock();
+			nodes = engine_stats.nodes;
+		}
+
+		*time_ms += ((double)(end - start) * 1000.0) / CLOCKS_PER_SEC;
+		free_board(&b);
+	}
+	return nodes;
+}
+
+static Record* find_record(Record* records, int count, Record* r) {
+	for (int i = 0; i < count; i++) {
+		if (records[i].kind == r->kind && records[i].position == r->position && records[i].depth == r->depth) {
+			return &records[i];
+		}
+	}
+	return NULL;
+}
+
+// repeats per sample of a workload, from the baseline if it has the workload, else from one timed run
+static int sample_repeats(Record* r, Record* baseline, int baseline_count) {
+	Record* base = find_record(baseline, baseline_count, r);
+	if (base) {
+		return base->repeats;
+	}
+	double time_ms, warm_ms;
+	run_workload(r->kind, r->position - 1, r->depth, 1, &time_ms);
+	if (time_ms < MIN_SAMPLE_MS) {
+		// the first run pays for cold caches, a short workload is timed again
+		run_workload(r->kind, r->position - 1, r->depth, 1, &warm_ms);
+		time_ms = warm_ms < time_ms ? warm_ms : time_ms;
+	}
+	return time_ms >= MIN_SAMPLE_MS ? 1 : (int)ceil(MIN_SAMPLE_MS / (time_ms > 1.0 ? time_ms : 1.0));
+}
+
+/*
+    The runs are interleaved: every run goes once through all workloads, so a burst of load on the
+    machine shows up as one bad sample in many workloads (which the median ignores) instead of as
+    all samples of a single workload.
+*/
+static int measure_all(Record* records, int runs, Record* baseline, int baseline_count) {
+	static double times[MAX_RECORDS][MAX_RUNS];
+	int count = 0;
+
+	for (int i = 0; i < num_bench_positions; i++) {
+		records[count++] = (Record){PERFT, i + 1, PERFT_DEPTH, 1, 0, 0, 0, 0};
+		records[count++] = (Record){SEARCH, i + 1, SEARCH_DEPTH, 1, 0, 0, 0, 0};
+	}
+	for (int i = 0; i < count; i++) {
+		records[i].repeats = sample_repeats(&records[i], baseline, baseline_count);
+	}
+
+	for (int run = 0; run < runs; run++) {
+		for (int i = 0; i < count; i++) {
+			Record* r = &records[i];
+			r->nodes = run_workload(r->kind, r->position - 1, r->depth, r->repeats, &times[i][run]);
+		}
+	}
+
+	for (int i = 0; i < count; i++) {
+		Record* r = &records[i];
+		r->median_ms = median(times[i], runs);
+		r->mad_ms = median_absolute_deviation(times[i], runs, r->median_ms);
+		r->nps = r->median_ms > 0 ? r->nodes * r->repeats * 1000.0 / r->median_ms : 0;
+	}
+	return count;
+}
+
+static int load_baseline(const char* filename, Record* records) {
+	FILE* file = fopen(filename, "r");
+	if (!file) {
+		return -1;
+	}
+
+	char line[256], kind[16];
+	int count = 0;
+	while (fgets(line, sizeof(line), file) && count < MAX_RECORDS) {
+		Record* r = &records[count];
+		if (line[0] == '#') {
+			continue;
+		}
+		if (sscanf(line, "%15[^,],%d,%d,%d,%llu,%lf,%lf,%lf", kind, &r->position, &r->depth, &r->repeats, &r->nodes, &r->median_ms, &r->mad_ms,
+		           &r->nps) != 8 || r->repeats < 1) {
+			continue;
+		}
+		r->kind = strcmp(kind, kind_names[PERFT]) == 0 ? PERFT : SEARCH;
+		count++;
+	}
+	fclose(file);
+	return count;
+}
+
+static void save_baseline(const char* filename, Record* records, int count) {
+	FILE* file = fopen(filename, "w");
+	if (!file) {
+		wprintf(L"Error writing %s\n", filename);
+		exit(2);
+	}
+	fprintf(file, "# kind,position,depth,repeats,nodes,median_ms,mad_ms,nps\n");
+	for (int i = 0; i < count; i++) {
+		Record* r = &records[i];
+		fprintf(file, "%s,%d,%d,%d,%llu,%.3lf,%.3lf,%.0lf\n", kind_names[r->kind], r->position, r->depth, r->repeats, r->nodes, r->median_ms, r->mad_ms,
+		        r->nps);
+	}
+	fclose(file);
+}
+
+/*
+    Compares one measurement with its baseline, prints the row and returns true on a regression.
+    If the node count changed, the current time is scaled to the baseline node count first, which
+    amounts to comparing the nodes/second.
+*/
+static bool compare_record(Record* current, Record* base, Options* options) {
+	bool nodes_changed = current->nodes != base->nodes;
+	double scale = current->nodes > 0 ? (double)base->nodes / current->nodes : 1.0;
+	double time = current->median_ms * scale;
+	double noise = options->mad_factor * (current->mad_ms * scale + base->mad_ms);
+
+	double change = base->median_ms > 0 ? (time / base->median_ms - 1.0) * 100.0 : 0;
+	bool slower = change > options->tolerance && time - base->median_ms > noise;
+	bool failed = slower || (nodes_changed && current->kind == PERFT);
+
+	const wchar_t* status = L"ok";
+	if (nodes_changed && current->kind == PERFT) {
+		status = L"FAIL (perft nodes changed)";
+	} else if (slower) {
+		status = L"FAIL (slower)";
+	} else if (nodes_changed) {
+		status = L"ok (search nodes changed)";
+	}
+
+	wprintf(L"%-6s %3d %5d %12llu %12llu %10.2lf %10.2lf %8.2lf  %ls\n", kind_names[current->kind], current->position, current->depth,
+	        base->nodes, current->nodes, base->median_ms, current->median_ms, change, status);
+	return failed;
+}
+
+static Options parse_options(int argc, char* argv[]) {
+	Options options = {false, DEFAULT_RUNS, DEFAULT_TOLERANCE, DEFAULT_MAD_FACTOR, BASELINE_FILE};
+
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "--update") == 0) {
+			options.update = true;
+		} else if (strcmp(argv[i], "--runs") == 0 && i + 1 < argc) {
+			options.runs = atoi(argv[++i]);
+		} else if (strcmp(argv[i], "--tolerance") == 0 && i + 1 < argc) {
+			options.tolerance = atof(argv[++i]);
+		} else if (strcmp(argv[i], "--mad-factor") == 0 && i + 1 < argc) {
+			options.mad_factor = atof(argv[++i]);
+		} else if (strcmp(argv[i], "--baseline") == 0 && i + 1 < argc) {
+			options.baseline = argv[++i];
+		} else {
+			wprintf(L"Unknown argument %s\n", argv[i]);
+			exit(2);
+		}
+	}
+
+	if (options.runs < 1 || options.runs > MAX_RUNS) {
+		wprintf(L"--runs must be between 1 and %d\n", MAX_RUNS);
+		exit(2);
+	}
+	return options;
+}
+
+int main(int argc, char* argv[]) {
+	setlocale(LC_ALL, "");
+	Options options = parse_options(argc, argv);
+	Record current[MAX_RECORDS], baseline[MAX_RECORDS];
+
+	int baseline_count = options.update ? 0 : load_baseline(options.baseline, baseline);
+	if (baseline_count < 0) {
+		wprintf(L"No baseline found at %s, record one with --update\n", options.baseline);
+		return 2;
+	}
+
+	init_zobrist(&transposition_table);
+	int count = measure_all(current, options.runs, baseline, baseline_count);
+
+	if (options.update) {
+		save_baseline(options.baseline, current, count);
+		wprintf(L"Baseline of %d workloads (%d runs each) written to %s\n", count, options.runs, options.baseline);
+		return 0;
+	}
+
+	wprintf(L"%-6s %3s %5s %12s %12s %10s %10s %8s  %s\n", "kind", "pos", "depth", "base nodes", "nodes", "base ms", "ms", "change%", "status");
+
+	int regressions = 0;
+	double base_total = 0, current_total = 0;
+	for (int i = 0; i < count; i++) {
+		Record* base = find_record(baseline, baseline_count, &current[i]);
+		if (!base) {
+			wprintf(L"%-6s %3d %5d: not in the baseline\n", kind_names[current[i].kind], current[i].position, current[i].depth);
+			continue;
+		}
+		regressions += compare_record(&current[i], base, &options);
+		base_total += base->median_ms;
+		current_total += current[i].median_ms;
+	}
+
+	wprintf(L"\nTotal: baseline %.2lf ms, current %.2lf ms (%+.2lf%%)\n", base_total, current_total,
+	        base_total > 0 ? (current_total / base_total - 1.0) * 100.0 : 0);
+
+	if (regressions) {
+		wprintf(L"%d regression(s) beyond %.1lf%% tolerance\n", regressions, options.tolerance);
+		return 1;
+	}
+	wprintf(L"No regressions\n");
+	return 0;
+}
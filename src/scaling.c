@@ -0,0 +1,136 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <wchar.h>
+#include <limits.h>
+#include <locale.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "chessboard.h"
+#include "move_types.h"
+#include "moves.h"
+#include "move_array.h"
+#include "engine.h"
+#include "transposition.h"
+#include "perft.h"
+#include "bench.h"
+
+/*
+    Thread scaling benchmark:
+    Runs the same perft and search workloads with 1, 2, 4, ... up to max_threads threads and
+    reports the time (for the search this is the time to reach the depth), the node rate, the
+    speedup over one thread and the efficiency (speedup / threads) of every thread count.
+
+    perft uses the perft test positions (the first bench positions), the search all bench
+    positions with an empty transposition table for every position. The perft node count must
+    be the same for every thread count, the search nodes will grow with the threads since the
+    threads can't prune each other's subtrees as well as the serial search does.
+
+    Time is wall clock time, clock() adds up the cpu time of all threads.
+
+    Usage: ./scaling [max_threads=cores] [perft_depth=4] [search_depth=5] [csv_file=scaling.csv]
+*/
+
+#define NUM_PERFT_POSITIONS 6
+#define DEFAULT_PERFT_DEPTH 4
+#define DEFAULT_CSV_FILE "scaling.csv"
+
+typedef struct {
+	int threads;
+	double time_ms;
+	unsigned long long nodes;
+} ScalingResult;
+
+static ScalingResult run_perft(int threads, int depth) {
+	ScalingResult r = {threads, 0, 0};
+	double start = wall_time_ms();
+	for (int i = 0; i < NUM_PERFT_POSITIONS; i++) {
+		r.nodes += perfit_parallel(depth, bench_positions[i].turn, bench_positions[i].fen, threads);
+	}
+	r.time_ms = wall_time_ms() - start;
+	return r;
+}
+
+static ScalingResult run_search(int threads, int depth) {
+	ScalingResult r = {threads, 0, 0};
+	for (int i = 0; i < num_bench_positions; i++) {
+		unsigned long long nodes;
+		clear_table(&transposition_table);
+
+		double start = wall_time_ms();
+		minimax_parallel(bench_positions[i].fen, depth, bench_positions[i].turn, threads, &nodes);
+		r.time_ms += wall_time_ms() - start;
+		r.nodes += nodes;
+	}
+	return r;
+}
+
+static void print_result(FILE* csv, const char* workload, ScalingResult r, ScalingResult single) {
+	double nps = r.time_ms > 0 ? r.nodes * 1000.0 / r.time_ms : 0;
+	double speedup = r.time_ms > 0 ? single.time_ms / r.time_ms : 0;
+	double efficiency = speedup / r.threads;
+
+	wprintf(L"%-7s %7d %12.1lf %14llu %12.0lf %8.2lf %9.1lf%%\n", workload, r.threads, r.time_ms, r.nodes, nps, speedup, efficiency * 100.0);
+	fprintf(csv, "%s,%d,%.3lf,%llu,%.0lf,%.3lf,%.3lf\n", workload, r.threads, r.time_ms, r.nodes, nps, speedup, efficiency);
+}
+
+int main(int argc, char* argv[]) {
+	setlocale(LC_ALL, "");
+	int max_threads = argc > 1 ? atoi(argv[1]) : (int)sysconf(_SC_NPROCESSORS_ONLN);
+	int perft_depth = argc > 2 ? atoi(argv[2]) : DEFAULT_PERFT_DEPTH;
+	int search_depth = argc > 3 ? atoi(argv[3]) : BENCH_DEPTH;
+	const char* csv_file = argc > 4 ? argv[4] : DEFAULT_CSV_FILE;
+
+	if (max_threads < 1 || perft_depth < 1 || search_depth < 1) {
+		wprintf(L"Usage: ./scaling [max_threads] [perft_depth] [search_depth] [csv_file]\n");
+		return 1;
+	}
+
+	FILE* csv = fopen(csv_file, "w");
+	if (!csv) {
+		wprintf(L"Error writing %s\n", csv_file);
+		return 1;
+	}
+	fprintf(csv, "workload,threads,time_ms,nodes,nps,speedup,efficiency\n");
+
+	init_zobrist(&transposition_table);
+
+	// 1, 2, 4, ... and max_threads itself if it isn't a power of 2
+	int thread_counts[32], num_counts = 0;
+	for (int t = 1; t < max_threads && num_counts < 31; t *= 2) {
+		thread_counts[num_counts++] = t;
+	}
+	thread_counts[num_counts++] = max_threads;
+
+	wprintf(L"Perft depth %d, search depth %d, up to %d threads\n\n", perft_depth, search_depth, max_threads);
+	wprintf(L"%-7s %7s %12s %14s %12s %8s %10s\n", "", "threads", "time (ms)", "nodes", "nodes/s", "speedup", "efficiency");
+
+	ScalingResult single_perft, single_search;
+	bool perft_mismatch = false;
+	for (int i = 0; i < num_counts; i++) {
+		ScalingResult r = run_perft(thread_counts[i], perft_depth);
+		if (i == 0) {
+			single_perft = r;
+		}
+		perft_mismatch |= r.nodes != single_perft.nodes;
+		print_result(csv, "perft", r, single_perft);
+	}
+	for (int i = 0; i < num_counts; i++) {
+		ScalingResult r = run_search(thread_counts[i], search_depth);
+		if (i == 0) {
+			single_search = r;
+		}
+		print_result(csv, "search", r, single_search);
+	}
+
+	fclose(csv);
+	wprintf(L"\nResults written to %s\n", csv_file);
+
+	if (perft_mismatch) {
+		wprintf(L"Error: the perft node count depends on the number of threads\n");
+		return 1;
+	}
+	return 0;
+}
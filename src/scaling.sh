@@ -0,0 +1,13 @@
+#!/bin/bash
+
+if ls *.c 1> /dev/null 2>&1; then
+    gcc $(ls *.c | grep -v -e 'main.c' -e 'tests.c' -e 'benchmark.c' -e 'regression.c') -lm -pthread -O2 -g -o scaling
+
+    if [ $? -eq 0 ]; then
+        echo "Compilation successful. Output file: scaling"
+    else
+        echo "Compilation failed."
+    fi
+else
+    echo "No C files found in the directory."
+fi
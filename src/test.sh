@@ -1,7 +1,7 @@
 #!/bin/bash
 
 if ls *.c 1> /dev/null 2>&1; then
-    gcc $(ls *.c | grep -v -e 'main.c' -e 'engine.c') -lm -g -o tests
+    gcc $(ls *.c | grep -v -e 'main.c' -e 'bench.c' -e 'benchmark.c' -e 'regression.c' -e 'scaling.c') -lm -pthread -g -o tests
 
     if [ $? -eq 0 ]; then
         echo "Compilation successful. Output file: tests"
@@ -0,0 +1,433 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <wchar.h>
+#include <locale.h>
+#include <time.h>
+#include <assert.h>
+
+#include "chessboard.h"
+#include "move_types.h"
+#include "moves.h"
+#include "move_array.h"
+#include "move_stack.h"
+#include "perft.h"
+#include "evaluation.h"
+#include "engine.h"
+#include "transposition.h"
+
+#define RED_TEXT "\033[0;31m"
+#define GREEN_TEXT "\033[0;32m"
+#define RESET "\033[0m"
+
+void print_squares_from_bb(uint64_t bb) {
+	for (int i = 0; i < 64; i++) {
+		if (bb & (1ULL << i)) {
+			int file = i % 8;
+			int rank = i / 8;
+			wprintf(L"%c%d ", file + 'a', rank + 1);
+		}
+	}
+	wprintf(L"\n");
+}
+#define STARTING_FEN "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1"
+#define TURN WHITE
+// #define MAX_DEPTH 6
+
+typedef struct {
+	char* fen;
+	int depth;
+	unsigned long long nodes;
+	unsigned long long expected_nodes;
+} PerftTest;
+
+#define TEST_1 "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1 "
+#define TEST_2 "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - "
+#define TEST_3 "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - "
+#define TEST_4 "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1"
+#define TEST_5 "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8 "
+#define TEST_6 "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10 "
+
+const PerftTest perft_test_suite[] = {
+    (PerftTest){TEST_1, 6, 0, 119060324},  // {20, 400, 8902, 197281, 4865609, 119060324}
+    (PerftTest){TEST_2, 5, 0, 193690690},  // {48, 2039, 97862, 4085603, 193690690}
+    (PerftTest){TEST_3, 7, 0, 178633661},   // {14, 191, 2812, 43238, 674624, 11030083}
+    (PerftTest){TEST_4, 5, 0, 15833292},   // {6, 264, 9467, 422333, 15833292}
+    (PerftTest){TEST_5, 5, 0, 89941194},   // {44, 1486, 62379, 2103487, 89941194}
+    (PerftTest){TEST_6, 5, 0, 164075551}   // {46, 2079, 89890, 3894594, 164075551}
+};
+
+#define MAX_STATS_DEPTH 5
+
+typedef struct {
+	char* fen;
+	int depth;
+	PerftStats expected[MAX_STATS_DEPTH];  // expected[i] -> stats at depth i + 1
+} PerftStatsTest;
+
+const PerftStatsTest perft_stats_test_suite[] = {
+    {TEST_1, 5, {
+        {20, 0, 0, 0, 0, 0, 0, 0, 0},
+        {400, 0, 0, 0, 0, 0, 0, 0, 0},
+        {8902, 34, 0, 0, 0, 12, 0, 0, 0},
+        {197281, 1576, 0, 0, 0, 469, 0, 0, 8},
+        {4865609, 82719, 258, 0, 0, 27351, 6, 0, 347}}},
+    {TEST_2, 4, {
+        {48, 8, 0, 2, 0, 0, 0, 0, 0},
+        {2039, 351, 1, 91, 0, 3, 0, 0, 0},
+        {97862, 17102, 45, 3162, 0, 993, 0, 0, 1},
+        {4085603, 757163, 1929, 128013, 15172, 25523, 42, 6, 43}}},
+    {TEST_3, 5, {
+        {14, 1, 0, 0, 0, 2, 0, 0, 0},
+        {191, 14, 0, 0, 0, 10, 0, 0, 0},
+        {2812, 209, 2, 0, 0, 267, 3, 0, 0},
+        {43238, 3348, 123, 0, 0, 1680, 106, 0, 17},
+        {674624, 52051, 1165, 0, 0, 52950, 1292, 3, 0}}},
+    // the published table for this position leaves out discovered and double checks,
+    // those two columns hold the counts of this engine
+    {TEST_4, 4, {
+        {6, 0, 0, 0, 0, 0, 0, 0, 0},
+        {264, 87, 0, 6, 48, 10, 0, 0, 0},
+        {9467, 1021, 4, 0, 120, 38, 2, 0, 22},
+        {422333, 131393, 0, 7795, 60032, 15492, 19, 0, 5}}}
+};
+
+static int unit_failures = 0;
+
+static void check(bool passed, const wchar_t* name) {
+	if (!passed) {
+		wprintf(L"%ls: " RED_TEXT "FAILED\n" RESET, name);
+		unit_failures++;
+	}
+}
+
+static void load_test_position(board* b, char* fen) {
+	load_fen(b, fen);
+	clear_move_list(b->white_attacks);
+	clear_move_list(b->black_attacks);
+	update_attacks_for_color(b, BLACK);
+	update_attacks_for_color(b, WHITE);
+}
+
+static bool compare_stats(PerftStats got, PerftStats expected) {
+	return memcmp(&got, &expected, sizeof(PerftStats)) == 0;
+}
+
+static void print_stats(int depth, PerftStats s) {
+	wprintf(L"%5d %12llu %10llu %8llu %9llu %10llu %9llu %9llu %8llu %8llu\n", depth, s.nodes, s.captures, s.en_passants, s.castles,
+	        s.promotions, s.checks, s.discovered_checks, s.double_checks, s.checkmates);
+}
+
+void perfit_stats_test(int max_depth) {
+	int num_tests = sizeof(perft_stats_test_suite) / sizeof(PerftStatsTest);
+	int failed = 0;
+
+	for (int i = 0; i < num_tests; i++) {
+		const PerftStatsTest* test = &perft_stats_test_suite[i];
+		int depth_limit = test->depth < max_depth ? test->depth : max_depth;
+
+		wprintf(L"Running test %d: %s\n", i + 1, test->fen);
+		wprintf(L"depth        nodes   captures       ep   castles promotions    checks disc.chk dbl.chk    mates\n");
+
+		for (int depth = 1; depth <= depth_limit; depth++) {
+			board b;
+			load_fen(&b, test->fen);
+
+			PerftStats stats = {0};
+			clock_t start = clock();
+			perfit_stats(depth, TURN, &b, &stats);
+			clock_t end = clock();
+
+			print_stats(depth, stats);
+			if (!compare_stats(stats, test->expected[depth - 1])) {
+				wprintf(RED_TEXT L"expected:\n" RESET);
+				print_stats(depth, test->expected[depth - 1]);
+				failed++;
+			}
+			if (depth == depth_limit) {
+				wprintf(L"time_ms = %.2lf\n", ((double)(end - start) * 1000.0) / CLOCKS_PER_SEC);
+			}
+		}
+	}
+
+	if (failed) {
+		wprintf(L"Extended perft: " RED_TEXT "%d FAILED\n" RESET, failed);
+	} else {
+		wprintf(L"Extended perft: " GREEN_TEXT "PASSED\n" RESET);
+	}
+}
+
+// passing and taking the pass back restores the position, the key of the other side to move in between
+void null_move_test() {
+	board b;
+	init_zobrist(&transposition_table);
+	load_fen(&b, "rnbqkbnr/ppp1pppp/8/8/3pP3/8/PPPP1PPP/RNBQKBNR b KQkq e3 0 3");
+	b.halfmove_clock = 12;
+	uint64_t en_passant_square = b.en_passant_square;
+	unsigned long long key = get_zobrist_key(&b, &transposition_table, BLACK);
+
+	make_null_move(&b);
+	check(b.en_passant_square == 0 && b.halfmove_clock == 12, L"null move: en passant square cleared, halfmove clock kept");
+	check(get_zobrist_key(&b, &transposition_table, WHITE) != key, L"null move: other side to move");
+
+	unmake_move(&b);
+	check(b.en_passant_square == en_passant_square && b.halfmove_clock == 12 && b.moves->top == NULL, L"null move: unmade");
+	check(get_zobrist_key(&b, &transposition_table, BLACK) == key, L"null move: zobrist key restored");
+}
+
+void single_perft_test(const char* fen, int depth, int turn) {
+	board b;
+	load_fen(&b, (char*)fen);
+	clear_move_list(b.white_attacks);
+	clear_move_list(b.black_attacks);
+
+	if (turn == WHITE) {
+		update_attacks_for_color(&b, BLACK);
+		update_attacks_for_color(&b, WHITE);
+
+		filter_legal_moves(&b, WHITE);
+	} else {
+		update_attacks_for_color(&b, WHITE);
+		update_attacks_for_color(&b, BLACK);
+
+		filter_legal_moves(&b, BLACK);
+	}
+
+	wprintf(L"White board: ");
+	print_squares_from_bb(b.white_board);
+
+	wprintf(L"\nBlack board: ");
+	print_squares_from_bb(b.black_board);
+
+	wprintf(L"\nblack king attacks: ");
+	print_squares_from_bb(generate_king_attacks(BLACK_KING, b.black->king, &b));
+
+	wprintf(L"\n========================================\n");
+
+	clock_t start = clock();
+	unsigned long long nodes = perfit(depth, turn, &b, depth);
+	clock_t end = clock();
+
+	wprintf(L"Nodes: %llu\n", nodes);
+	wprintf(L"time_ms = %.2lf\n", ((double)(end - start) * 1000.0) / CLOCKS_PER_SEC);
+
+	return;
+}
+
+void perfit_test() {
+	int num_tests = sizeof(perft_test_suite) / sizeof(PerftTest);
+	for (int i = 0; i < num_tests; i++) {
+		board b;
+		init_board(&b);
+		load_fen(&b, perft_test_suite[i].fen);
+		clear_move_list(b.white_attacks);
+		clear_move_list(b.black_attacks);
+
+		update_attacks_for_color(&b, BLACK);
+		update_attacks_for_color(&b, WHITE);
+
+		wprintf(L"Running test %d: %s\n", i + 1, perft_test_suite[i].fen);
+		clock_t start = clock();
+		unsigned long long nodes = perfit(perft_test_suite[i].depth, TURN, &b, perft_test_suite[i].depth);
+		clock_t end = clock();
+		double time = ((double)(end - start) * 1000.0) / CLOCKS_PER_SEC;
+		wprintf(L"Nodes: %llu, time_ms = %.2lf\n", nodes, time);
+
+		if (nodes == perft_test_suite[i].expected_nodes) {
+			wprintf(L"Test %d: " GREEN_TEXT "PASSED\n" RESET, i + 1);
+		} else {
+			wprintf(L"Test %d: " RED_TEXT "FAILED\n" RESET, i + 1);
+			wprintf(L"Expected: %llu, Got: %llu\n", perft_test_suite[i].expected_nodes, nodes);
+		}
+	}
+}
+
+// material of positions loaded with pieces missing, from white's point of view
+void evaluation_test() {
+	board b;
+	load_test_position(&b, "rnb1kbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1");
+	check(get_evaluation_of_board(&b) == 9 * PAWN_VALUE, L"eval: black queen missing");
+
+	load_test_position(&b, "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/1NBQKBNR w Kkq - 0 1");
+	check(get_evaluation_of_board(&b) == -5 * PAWN_VALUE, L"eval: white rook missing");
+
+	load_test_position(&b, "8/8/8/8/4k3/8/8/3QK3 w - - 0 1");
+	check(get_evaluation_of_board(&b) > 0, L"eval: king and queen against king");
+}
+
+// repetitions within the halfmove clock, the fifty move rule and positions without mating material
+void draw_test() {
+	board b;
+	load_test_position(&b, STARTING_FEN);
+
+	// the positions before the one at the root, a knight went out and back on both sides
+	uint64_t keys[4] = {11, 12, 13, 14};
+	clear_position_history();
+	for (int i = 0; i < 4; i++) {
+		record_position(keys[i]);
+	}
+	b.halfmove_clock = 4;
+	check(is_repetition(&b, keys[0], 0), L"draw: repetition");
+	check(!is_repetition(&b, keys[1], 0), L"draw: other side to move");
+	check(!is_repetition(&b, 15, 0), L"draw: new position");
+	b.halfmove_clock = 3;
+	check(!is_repetition(&b, keys[0], 0), L"draw: repetition before a capture or pawn move");
+	clear_position_history();
+
+	// every move of white reaches the hundredth ply without a capture or pawn move
+	init_zobrist(&transposition_table);
+	load_test_position(&b, "8/8/8/8/4k3/8/8/3QK3 w - - 99 1");
+	clear_table(&transposition_table);
+	check(minimax(&b, 3, WHITE, -INFINITE_SCORE, INFINITE_SCORE).evaluation == DRAW_SCORE, L"draw: fifty move rule");
+	load_test_position(&b, "8/8/8/8/4k3/8/8/3QK3 w - - 0 1");
+	clear_table(&transposition_table);
+	check(minimax(&b, 3, WHITE, -INFINITE_SCORE, INFINITE_SCORE).evaluation >= 8 * PAWN_VALUE, L"draw: fifty move rule not reached");
+
+	load_test_position(&b, "8/8/8/8/4k3/8/8/4K3 w - - 0 1");
+	check(insufficient_material(&b), L"draw: king against king");
+	load_test_position(&b, "8/8/8/8/4k3/8/8/4KN2 w - - 0 1");
+	check(insufficient_material(&b), L"draw: king and knight against king");
+	load_test_position(&b, "8/8/8/8/4k3/8/8/4Kb2 w - - 0 1");
+	check(insufficient_material(&b), L"draw: king and bishop against king");
+	load_test_position(&b, "8/8/8/8/4k3/8/4P3/4K3 w - - 0 1");
+	check(!insufficient_material(&b), L"draw: king and pawn against king");
+}
+
+// the legal move of 'turn' written like "e7e8q" (promotions to a queen only), PLACEHOLDER_MOVE if there is none
+static Move find_legal_move(board* b, short turn, const char* move) {
+	MoveList* legal_moves = turn == WHITE ? b->white_legal_moves : b->black_legal_moves;
+	clear_move_list(legal_moves);
+	filter_legal_moves(b, turn);
+
+	for (int i = 0; i < legal_moves->move_count; i++) {
+		Move m = legal_moves->moves[i];
+		bool promotion = m.promoted_piece && piece_type_from_promotion_flag(m.type) == QUEEN;
+		if (m.src.file == move[0] - 'a' + 1 && m.src.rank == move[1] - '0' && m.dest.file == move[2] - 'a' + 1 &&
+		    m.dest.rank == move[3] - '0' && (move[4] == 'q' ? promotion : !m.promoted_piece)) {
+			return m;
+		}
+	}
+	return PLACEHOLDER_MOVE;
+}
+
+static int see_of(char* fen, const char* move) {
+	board b;
+	load_test_position(&b, fen);
+	return static_exchange_evaluation(find_legal_move(&b, WHITE, move), WHITE, &b);
+}
+
+// material white wins on the destination square, in centipawns
+void see_test() {
+	check(see_of("4k3/8/8/3p4/8/8/8/3RK3 w - - 0 1", "d1d5") == PAWN_VALUE, L"see: undefended pawn");
+	check(see_of("4k3/8/4p3/3p4/8/8/8/3RK3 w - - 0 1", "d1d5") == -4 * PAWN_VALUE, L"see: pawn defended by a pawn");
+
+	// the queen behind the rook recaptures once the rook is gone
+	check(see_of("3rk3/8/8/3p4/8/3R4/8/4K3 w - - 0 1", "d3d5") == -4 * PAWN_VALUE, L"see: rook against defended pawn");
+	check(see_of("3rk3/8/8/3p4/8/3R4/8/3QK3 w - - 0 1", "d3d5") == PAWN_VALUE, L"see: x-ray through the rook");
+
+	// the king recaptures only on an undefended square
+	check(see_of("8/8/4k3/3p4/8/8/8/3RK3 w - - 0 1", "d1d5") == -4 * PAWN_VALUE, L"see: king as the last attacker");
+	check(see_of("8/8/4k3/3p4/8/1B6/8/3RK3 w - - 0 1", "d1d5") == PAWN_VALUE, L"see: king can't recapture");
+
+	check(see_of("7k/4P3/8/8/8/8/8/4K3 w - - 0 1", "e7e8q") == 8 * PAWN_VALUE, L"see: promotion");
+	check(see_of("r6k/4P3/8/8/8/8/8/4K3 w - - 0 1", "e7e8q") == -PAWN_VALUE, L"see: promotion on a defended square");
+}
+
+static bool stored(ZobristTable* z, unsigned long long key) {
+	Entry e;
+	return get_entry(z, key, &e);
+}
+
+// a table of a single bucket, so every key competes for the same entries
+void transposition_test() {
+	ZobristTable z = {0};
+	resize_table(&z, 0);
+	Entry e;
+	board b;
+
+	// moves keep src, dest and the promotion piece
+	load_test_position(&b, STARTING_FEN);
+	Move m = find_legal_move(&b, WHITE, "g1f3");
+	insert_entry(&z, 0x100000001ULL, m, 25, 4, BOUND_EXACT);
+	Move unpacked = get_entry(&z, 0x100000001ULL, &e) ? entry_move(&e, WHITE) : PLACEHOLDER_MOVE;
+	check(unpacked.src.file == 7 && unpacked.src.rank == 1 && unpacked.dest.file == 6 && unpacked.dest.rank == 3 && !unpacked.type,
+	      L"tt: move round trip");
+	check(entry_score(&e) == 25 && e.depth == 4 && entry_bound(&e) == BOUND_EXACT, L"tt: entry fields");
+
+	load_test_position(&b, "7k/4P3/8/8/8/8/8/4K3 w - - 0 1");
+	m = find_legal_move(&b, WHITE, "e7e8q");
+	insert_entry(&z, 0x200000001ULL, m, 0, 1, BOUND_LOWER);
+	unpacked = get_entry(&z, 0x200000001ULL, &e) ? entry_move(&e, WHITE) : PLACEHOLDER_MOVE;
+	check(unpacked.dest.file == 5 && unpacked.dest.rank == 8 && unpacked.type == WHITE_PROMOTES_TO_QUEEN, L"tt: promotion round trip");
+
+	// an entry of the same position without a move keeps the old one
+	insert_entry(&z, 0x200000001ULL, PLACEHOLDER_MOVE, -10, 2, BOUND_UPPER);
+	check(get_entry(&z, 0x200000001ULL, &e) && entry_move(&e, WHITE).type == WHITE_PROMOTES_TO_QUEEN && entry_score(&e) == -10,
+	      L"tt: move kept");
+
+	// only the upper 32 bits of the key are stored, a torn entry isn't returned
+	check(!stored(&z, 0x300000001ULL), L"tt: other key");
+	check(stored(&z, 0x100000001ULL), L"tt: same key");
+	z.table[0].entries[0].score++;  // the entry stored first, of key 0x100000001
+	check(!stored(&z, 0x100000001ULL), L"tt: torn entry");
+
+	// a full bucket replaces the least depth, where every generation of age costs AGE_PENALTY plies
+	clear_table(&z);
+	int depths[BUCKET_SIZE] = {10, 2, 8, 6, 4};
+	for (int i = 0; i < BUCKET_SIZE; i++) {
+		insert_entry(&z, (unsigned long long)(i + 1) << 32, PLACEHOLDER_MOVE, 0, depths[i], BOUND_EXACT);
+	}
+	insert_entry(&z, 6ULL << 32, PLACEHOLDER_MOVE, 0, 3, BOUND_EXACT);
+	check(!stored(&z, 2ULL << 32) && stored(&z, 6ULL << 32), L"tt: least depth replaced");
+
+	new_search(&z);
+	new_search(&z);
+	insert_entry(&z, 7ULL << 32, PLACEHOLDER_MOVE, 0, 1, BOUND_EXACT);
+	insert_entry(&z, 8ULL << 32, PLACEHOLDER_MOVE, 0, 1, BOUND_EXACT);
+	check(!stored(&z, 6ULL << 32) && !stored(&z, 5ULL << 32), L"tt: old entries replaced");
+	check(stored(&z, 7ULL << 32) && stored(&z, 8ULL << 32) && stored(&z, 1ULL << 32), L"tt: new entries kept");
+
+	// a bound only decides the node if it is outside the window
+	check(bound_cutoff(BOUND_EXACT, 0, -50, 50), L"tt: exact");
+	check(bound_cutoff(BOUND_LOWER, 50, -50, 50) && !bound_cutoff(BOUND_LOWER, 49, -50, 50), L"tt: lower bound");
+	check(bound_cutoff(BOUND_UPPER, -50, -50, 50) && !bound_cutoff(BOUND_UPPER, -49, -50, 50), L"tt: upper bound");
+	check(!bound_cutoff(BOUND_NONE, 100, -50, 50), L"tt: empty entry");
+
+	free(z.table);
+}
+
+void unit_test() {
+	unit_failures = 0;
+	evaluation_test();
+	draw_test();
+	see_test();
+	transposition_test();
+	null_move_test();
+
+	if (unit_failures) {
+		wprintf(L"Unit tests: " RED_TEXT "%d FAILED\n" RESET, unit_failures);
+	} else {
+		wprintf(L"Unit tests: " GREEN_TEXT "PASSED\n" RESET);
+	}
+}
+
+/*
+    Usage:
+    ./tests                 -> unit tests, then the node count perft suite
+    ./tests unit            -> unit tests only
+    ./tests stats [depth]   -> extended perft suite, every depth up to 'depth' (default 5)
+*/
+int main(int argc, char* argv[]) {
+	setlocale(LC_ALL, "");
+	if (argc > 1 && strcmp(argv[1], "stats") == 0) {
+		perfit_stats_test(argc > 2 ? atoi(argv[2]) : MAX_STATS_DEPTH);
+		return 0;
+	}
+	unit_test();
+	if (argc > 1 && strcmp(argv[1], "unit") == 0) {
+		return 0;
+	}
+	perfit_test();
+	return 0;
+}
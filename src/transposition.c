@@ -1,6 +1,13 @@
+#include <limits.h>
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+
 #include "move_types.h"
 #include "transposition.h"
 
+ZobristTable transposition_table;
+
 unsigned long long random_64() {
 	unsigned long long r = 0;
 	for (int i = 0; i < 4; i++) {
@@ -34,16 +41,7 @@ unsigned long long random_64() {
     index = (color * 6) + (type - 1)
 */
 
-static bool is_power_of_2(unsigned long long x) {
-	return x && !(x & (x - 1));
-}
-
 void init_zobrist(ZobristTable* z) {
-	if (!is_power_of_2(TABLE_SIZE)) {
-		fprintf(stderr, "Error: TABLE_SIZE must be power of 2\n");
-		exit(1);
-	}
-
 	for (int i = 0; i < 12; i++) {
 		for (int j = 0; j < 64; j++) {
 			z->keys[i][j] = random_64();
@@ -55,62 +53,150 @@ void init_zobrist(ZobristTable* z) {
 	}
 	z->en_passant = random_64();
 
-	for (size_t i = 0; i < TABLE_SIZE; i++) {
-		z->table[i].key = 0; 
-		z->table[i].depth = 0;
+	if (!z->table && !resize_table(z, DEFAULT_HASH_MB)) {
+		exit(1);
+	}
+	clear_table(z);
+}
+
+// allocates an empty table of (at most) 'megabytes' MB, the old table is kept if that fails
+bool resize_table(ZobristTable* z, size_t megabytes) {
+	size_t num_buckets = 1;
+	while (num_buckets * 2 * sizeof(Bucket) <= megabytes * 1024 * 1024) {
+		num_buckets *= 2;
 	}
 
-    z->num_entries = 0;
+	size_t bytes = num_buckets * sizeof(Bucket);
+	void* table = NULL;
+	if (posix_memalign(&table, bytes >= HUGE_PAGE_SIZE ? HUGE_PAGE_SIZE : sizeof(Bucket), bytes) != 0) {
+		fprintf(stderr, "Error: could not allocate a %zu MB transposition table\n", megabytes);
+		return false;
+	}
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+	if (bytes >= HUGE_PAGE_SIZE) {
+		madvise(table, bytes, MADV_HUGEPAGE);
+	}
+#endif
+
+	free(z->table);
+	z->table = table;
+	z->num_buckets = num_buckets;
+	clear_table(z);
+	return true;
 }
 
-void insert_entry(ZobristTable* z, Entry e) {
-	unsigned long long mask = TABLE_SIZE - 1;
-	unsigned long long initial_index = e.key & mask;
-	unsigned long long index = initial_index;
-	int i = 1;
+// empties the table but keeps the zobrist keys, so the keys of the positions don't change
+void clear_table(ZobristTable* z) {
+	memset(z->table, 0, z->num_buckets * sizeof(Bucket));
+	z->num_entries = 0;
+	z->generation = 0;
+}
 
-	while (true) {
-		if (z->table[index].key == 0 || z->table[index].key == e.key) {
-			z->table[index] = e;
-            z->num_entries++;
-			return;
-		}
+void new_search(ZobristTable* z) {
+	z->generation = (z->generation + 1) & 63;
+}
 
-		if (z->table[index].depth <= e.depth) {
-			z->table[index] = e;
-			return;
-		}
+uint8_t entry_bound(Entry* e) {
+	return e->flags & 3;
+}
 
-		index = (initial_index + (i * i)) & mask;
-		i++;
+static uint8_t entry_age(ZobristTable* z, Entry* e) {
+	return (z->generation - (e->flags >> 2)) & 63;
+}
 
-		if (i >= 100) {
-			z->table[index] = e;
-			return;
-		}
+int entry_score(Entry* e) {
+	return e->score;
+}
+
+// a stored score with bound 'bound' decides a node searched with the window (alpha, beta)
+bool bound_cutoff(uint8_t bound, int score, int alpha, int beta) {
+	return bound == BOUND_EXACT || (bound == BOUND_LOWER && score >= beta) || (bound == BOUND_UPPER && score <= alpha);
+}
+
+// the fields of an entry but the key, folded into 32 bits
+static uint32_t entry_data(Entry* e) {
+	return ((uint32_t)e->move | (uint32_t)(uint16_t)e->score << 16) ^ ((uint32_t)e->depth | (uint32_t)e->flags << 8);
+}
+
+// the upper 32 bits of the zobrist key of the entry, if it isn't torn
+static uint32_t entry_key(Entry* e) {
+	return e->key ^ entry_data(e);
+}
+
+static uint16_t pack_move(Move m) {
+	if (m.src.file == 0) {
+		return 0;
+	}
+	uint16_t promotion = 0;
+	if ((m.type & PROMOTION_MOVE_MASK) == WHITE_PROMOTION_MOVE || (m.type & PROMOTION_MOVE_MASK) == BLACK_PROMOTION_MOVE) {
+		promotion = (m.type >> 4) + 1;  // piece type, see the promotion flags in move_types.h
 	}
+	uint16_t from = (m.src.file - 1) + 8 * (m.src.rank - 1);
+	uint16_t to = (m.dest.file - 1) + 8 * (m.dest.rank - 1);
+	return from | (to << 6) | (promotion << 12);
 }
 
-Entry* get_entry(ZobristTable* z, unsigned long long key) {
-	unsigned long long mask = TABLE_SIZE - 1;
-	unsigned long long initial_index = key & mask;
-	unsigned long long index = initial_index;
-	int i = 1;
+// only src, dest and the promotion flag are known, like the moves of the opening book
+Move entry_move(Entry* e, short turn) {
+	Move m = {0};
+	if (!e->move) {
+		return m;
+	}
+	uint16_t from = e->move & 63, to = (e->move >> 6) & 63, promotion = e->move >> 12;
+	m.src = (square){.file = from % 8 + 1, .rank = from / 8 + 1};
+	m.dest = (square){.file = to % 8 + 1, .rank = to / 8 + 1};
+	if (promotion) {
+		m.type = ((promotion - 1) << 4) | (turn == WHITE ? WHITE_PROMOTION_MOVE : BLACK_PROMOTION_MOVE);
+	}
+	return m;
+}
 
-	while (z->table[index].key != 0) {
-		if (z->table[index].key == key) {
-			return &z->table[index];
+/*
+    One store per searched node: an entry of the same position is overwritten (keeping its move if
+    the new result has none), otherwise an empty entry is used or the one worth the least
+    (depth - AGE_PENALTY * age) is replaced.
+*/
+void insert_entry(ZobristTable* z, unsigned long long key, Move move, int score, int depth, uint8_t bound) {
+	Bucket* bucket = &z->table[key & (z->num_buckets - 1)];
+	uint32_t fragment = key >> 32;
+	Entry* replace = &bucket->entries[0];
+
+	for (int i = 0; i < BUCKET_SIZE; i++) {
+		Entry* e = &bucket->entries[i];
+		if (entry_bound(e) == BOUND_NONE || entry_key(e) == fragment) {
+			replace = e;
+			break;
 		}
+		if (e->depth - AGE_PENALTY * entry_age(z, e) < replace->depth - AGE_PENALTY * entry_age(z, replace)) {
+			replace = e;
+		}
+	}
 
-		index = (initial_index + (i * i)) & mask;
-		i++;
+	uint16_t packed = pack_move(move);
+	if (entry_bound(replace) == BOUND_NONE) {
+		z->num_entries++;
+	} else if (entry_key(replace) == fragment && !packed) {
+		packed = replace->move;
+	}
+
+	Entry entry = {.move = packed, .score = score, .depth = depth, .flags = bound | (z->generation << 2)};
+	entry.key = fragment ^ entry_data(&entry);
+	*replace = entry;
+}
 
-		if (i >= 100) {
-			return NULL;
+// copies the entry of the position to 'entry', false if there is none
+bool get_entry(ZobristTable* z, unsigned long long key, Entry* entry) {
+	Bucket* bucket = &z->table[key & (z->num_buckets - 1)];
+	uint32_t fragment = key >> 32;
+
+	for (int i = 0; i < BUCKET_SIZE; i++) {
+		Entry e = bucket->entries[i];  // another thread may store to the bucket meanwhile
+		if (entry_key(&e) == fragment && entry_bound(&e) != BOUND_NONE) {
+			*entry = e;
+			return true;
 		}
 	}
-
-	return NULL;
+	return false;
 }
 
 unsigned piece_index(uint8_t piece) {
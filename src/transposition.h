@@ -2,6 +2,7 @@
 #define TRANSPOSITION_H
 #include <stdio.h>
 #include <stdint.h>
+#include <stdbool.h>
 #include <stdlib.h>
 #include <string.h>
 #include <wchar.h>
@@ -9,16 +10,41 @@
 #include <time.h>
 // #include "chessboard.h"
 // #include "move_types.h"
+
+/*
+    Transposition table entries:
+    An entry is 12 bytes, 5 of them fill a bucket of one cache line (64 bytes), so a probe touches
+    a single cache line. The lower bits of the zobrist key select the bucket, the upper 32 bits are
+    stored in the entry to tell the positions of a bucket apart.
+
+    key   : the upper 32 bits of the zobrist key xor the other fields folded into 32 bits. Threads
+            share the table without locks, so an entry can be torn (the fields of two stores mixed
+            up). get_entry copies the entry and only returns it if key and fields still match.
+
+    move  : from square (6 bits) | to square (6 bits) | promotion piece type (3 bits), squares are
+            (file - 1) + 8 * (rank - 1). Castles and en passant are recognised by make_move itself.
+    score : centipawns from the point of view of the side to move, see MATE_SCORE. The search
+            stores mates relative to the position (a mate n plies away is +-(MATE_SCORE - n)),
+            not to the root.
+    flags : bound type (2 bits) | generation (6 bits)
+            EXACT -> the score is exact, LOWER -> the real score is >= score (fail high),
+            UPPER -> the real score is <= score (fail low), NONE -> empty entry.
+*/
 typedef struct {
-    unsigned long long key;
-    unsigned depth;
-    double evaluation;
-    Move best_move;
-    double alpha;
-    double beta;
-    bool is_book_move;
+    uint32_t key;
+    uint16_t move;
+    int16_t score;
+    uint8_t depth;
+    uint8_t flags;
 } Entry;
 
+enum { BOUND_NONE = 0, BOUND_EXACT = 1, BOUND_LOWER = 2, BOUND_UPPER = 3 };
+
+#define BUCKET_SIZE 5
+
+typedef struct {
+    _Alignas(64) Entry entries[BUCKET_SIZE];
+} Bucket;
 
 /*
     Zobrist keys:
@@ -27,23 +53,46 @@ typedef struct {
     of the board from the transposition table using the zobrist key.
 
     1. 12 pieces will have unique keys for each square.
+
+    Aging: every search increments the generation of the table (new_search). When a bucket is full,
+    the entry with the least depth is replaced, where every generation an entry is old counts
+    as AGE_PENALTY plies less depth, so the table doesn't fill up with deep entries of positions
+    that are long gone.
 */
 
-#define TABLE_SIZE 1048576
+/*
+    Table size:
+    The buckets are allocated at runtime (resize_table) from a size in MB, the bucket count is the
+    largest power of 2 that fits, so the bucket of a key is just key & (num_buckets - 1). Tables of
+    at least one huge page are aligned to it and, on Linux, advised to be backed by transparent
+    huge pages: a random access over gigabytes of table would otherwise miss the TLB nearly always.
+*/
+#define DEFAULT_HASH_MB 32
+#define HUGE_PAGE_SIZE (2 * 1024 * 1024)
+#define AGE_PENALTY 8
 typedef struct zobrist {
     unsigned long long keys[12][64];
     unsigned long long white_to_move;
     unsigned long long castling[4];
     unsigned long long en_passant;
     unsigned long long num_entries;
-    Entry table[TABLE_SIZE];
+    uint8_t generation;
+    Bucket* table;
+    unsigned long long num_buckets;
 } ZobristTable;
 
 extern ZobristTable transposition_table;
 
 unsigned long long random_64();
 void init_zobrist(ZobristTable* z);
-void insert_entry(ZobristTable* z, Entry e);
+bool resize_table(ZobristTable* z, size_t megabytes);
+void clear_table(ZobristTable* z);
+void new_search(ZobristTable* z);
+void insert_entry(ZobristTable* z, unsigned long long key, Move move, int score, int depth, uint8_t bound);
+bool get_entry(ZobristTable* z, unsigned long long key, Entry* entry);
+uint8_t entry_bound(Entry* e);
+int entry_score(Entry* e);
+bool bound_cutoff(uint8_t bound, int score, int alpha, int beta);
+Move entry_move(Entry* e, short turn);
 unsigned long long get_zobrist_key(board* b, ZobristTable* z, short turn);
-Entry* get_entry(ZobristTable* z, unsigned long long key);
-#endif
\ No newline at end of file
+#endif